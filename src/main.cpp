@@ -61,16 +61,42 @@
  * 
  * Wiping all memory slots in EEPROM:
  * AMWIPE
+ *
+ * Command strings like these can be stored as macros ('K' menu, 4 of them, in EEPROM).
+ * A macro is fed to the commands from the EEPROM directly, instead of the serial input,
+ * so it runs without any flow control or serial catch-up waits, the same way every time.
  */
 
-#define PRINT_UID_to_serial Serial.print(F("<UID> AT ")); Serial.println(__LINE__);
+#define PRINT_UID_to_serial Console.print(F("<UID> AT ")); Console.println(__LINE__);
 
 #define USE_SERIAL true  //set to true for Serial output, false for no Serial at all.
-#define S if(USE_SERIAL)Serial
+#define S if(USE_SERIAL)Console
 
 #define PRINT_DEBUG_SERIAL true  //set to true for Serial output, false for no Serial at all.
-#define SDBGprint if(PRINT_DEBUG_SERIAL)Serial.print
-#define SDBGprintln if(PRINT_DEBUG_SERIAL)Serial.println
+#define SDBGprint if(PRINT_DEBUG_SERIAL)Console.print
+#define SDBGprintln if(PRINT_DEBUG_SERIAL)Console.println
+
+#define CONSOLE_TX_QUEUE (RAMEND > 0x900 ? 256 : 128) //Console output queue in RAM (Bytes, power of 2, up to 256), on top of the serial port's own TX buffer.
+#define CONSOLE_TX_BURST 16 //Most Bytes moved to the serial port per 1 ms drain tick, keeps the interrupt short (16 kB/s is still above 115200 Bd).
+
+#define USE_LOW_POWER true  //set to true to let the MCU sleep between polls (AVR only), false to always busy-wait.
+#define CLONE_QUEUE_SIZE 8  //IDs buffered in RAM by the 'Q' streaming clone queue.
+#define CLONE_QUEUE_LINE 17 //Longest queue line: 16 hex digits + newline.
+#if defined(SERIAL_RX_BUFFER_SIZE)  //Lines we can grant at once, serial isn't read while a blank is being written.
+#define CLONE_QUEUE_RX_LINES ((SERIAL_RX_BUFFER_SIZE - 1) / CLONE_QUEUE_LINE)
+#else
+#define CLONE_QUEUE_RX_LINES 3
+#endif
+
+#define READ_SAMPLES 5      //ROM samples a read may take, when the consecutive ones keep disagreeing (flaky contact).
+
+#define USE_OVERDRIVE true  //set to true to allow the opt-in ('O') overdrive speed reads (AVR only), false to leave them out.
+#define USE_EMULATION true  //set to true to enable the 'U' DS1990A slave emulation (AVR only), false to leave it out.
+#define USE_MEMORY_REPORT true  //set to true for the 'H' RAM / stack high-water mark report (AVR only), false to leave it out.
+#define USE_TRACE true      //set to true to enable the 'T' trace recording (serial input, 1-Wire bus & EEPROM writes, see tools/trace), false to leave it out.
+
+#define WDT_TICK_MS 125     //Watchdog wake-up period while in POWER-DOWN sleep (WDP1 | WDP0 prescaler), paces the 1-Wire presence checks.
+#define SERIAL_AWAKE_MS 10000UL //POWER-DOWN is replaced by IDLE for this long after serial input (or a pin change wake-up), so the rest of a typed / pasted input isn't lost.
 
 
 #define IBUTTON 10 //iButton center, see above graphic
@@ -81,15 +107,202 @@
 #define READ 8 //Grounding button for reading
 #define WRITE 9 //Grounding button for writing
 
+#define USE_MULTI_PROBE true      //set to true to enable the 'N' multi-probe clone, false to leave it out.
+#define PROBE_PINS IBUTTON, 16, 14  //iButton contacts for the multi-probe clone, each one needs its own 4.7k pull-up.
+#define PROBE_SETTLE_MS 300       //Wait this long after the last detected blank, so more of them can join the same write batch.
+
 #include <Arduino.h>
 #include <EEPROM.h>
 #include <OneWire.h>
 
+#if defined(__AVR__) && !defined(USBCON)
+#define CONSOLE_TX_ISR true //Console output is drained by the Timer0 compare interrupt. USB serial can't be fed from an interrupt, there yield() & idle_sleep() drain it.
+#else
+#define CONSOLE_TX_ISR false
+#endif
+
+#if USE_LOW_POWER == true && defined(__AVR__)
+#include <avr/sleep.h>
+#include <avr/wdt.h>
+#include <avr/interrupt.h>
+#endif
 
-const PROGMEM int SLOT[] = {9, 7, 6, 5}; //pins for activeMemSlot address, LSB first, grounding switches
+const PROGMEM int SLOT[] = {9, 7, 6, 5}; //pins for activeMemSlot address, LSB first, grounding switches. SLOT[0] is the WRITE pin too!
 PROGMEM const byte WIPE_CONFIRMATION[] = {'I', 'P', 'E'};  //WIPE_CONFIRMATION CHARACTERS for confirming wipe.
 
-OneWire ibutton(IBUTTON);
+struct MemoryFamily {     //Memory iButtons, whose NV memory is readable by the Read Memory (0xF0) command
+  byte family;
+  unsigned int pages;     //32 Byte pages
+};
+PROGMEM const MemoryFamily MEMORY_FAMILIES[] = {
+  {0x08, 4},              //DS1992 1 Kbit NV RAM
+  {0x06, 16},             //DS1993 4 Kbit NV RAM
+  {0x04, 16},             //DS1994 4 Kbit NV RAM + RTC
+  {0x0A, 64},             //DS1995 16 Kbit NV RAM
+  {0x0C, 256},            //DS1996 64 Kbit NV RAM
+  {0x2D, 4},              //DS1972 1 Kbit EEPROM
+  {0x23, 16},             //DS1973 4 Kbit EEPROM
+};
+
+#define BLANK_BIT_PULSES 0      //Every data bit is one programming pulse, followed by a recovery
+#define BLANK_BYTE_PROGRAM 1    //Data goes as ordinary 1-Wire bytes, each one followed by a programming pulse, a pause & an echo
+
+struct BlankDriver {            //How to write one type of writable blank
+  const char *name;             //PROGMEM string
+  byte encoding;                //BLANK_BIT_PULSES / BLANK_BYTE_PROGRAM
+  byte flagWrite;               //Write record flag opcode, unlocks writing (0x00 = the legacy preamble instead)
+  byte flagRead;                //Probe opcode for the auto-detection (0x00 = can't be detected, only forced)
+  byte writeRom;                //Write ROM opcode
+  bool unlockBit;               //Record flag value that allows writing
+  bool relock;                  //Write the record flag back after writing
+  bool invertBits;              //Data bits are sent inverted, compared to the RW1990 encoding
+  byte pulseUs;                 //Programming pulse of a '1' bit (BIT_PULSES) / 1-Wire idle before the programming pulse, in 10 us (BYTE_PROGRAM)
+  byte recoveryMs;              //Recovery after each bit (BIT_PULSES) / programming time after each byte (BYTE_PROGRAM)
+};
+
+const char BLANK_NAME_TM2004[] PROGMEM = "TM2004";
+const char BLANK_NAME_RW1990_1[] PROGMEM = "RW1990.1";
+const char BLANK_NAME_RW1990_2[] PROGMEM = "RW1990.2 / TM1990";
+const char BLANK_NAME_TM01C[] PROGMEM = "TM01C";
+const char BLANK_NAME_LEGACY[] PROGMEM = "RW1990 (legacy sequence)";
+
+PROGMEM const BlankDriver BLANK_DRIVERS[] = { //Most specific probe first, the auto-probe takes the first one that answers
+  {BLANK_NAME_TM2004, BLANK_BYTE_PROGRAM, 0x00, 0xAA, 0x3C, false, false, false, 60, 50},
+  {BLANK_NAME_RW1990_1, BLANK_BIT_PULSES, 0xD1, 0xB5, 0xD5, false, true, false, 60, 10},
+  {BLANK_NAME_RW1990_2, BLANK_BIT_PULSES, 0x1D, 0x1E, 0xD5, true, true, true, 60, 10},
+  {BLANK_NAME_TM01C, BLANK_BIT_PULSES, 0xC1, 0x00, 0xC5, true, false, false, 60, 10},
+  {BLANK_NAME_LEGACY, BLANK_BIT_PULSES, 0x00, 0x00, 0xD5, false, false, false, 60, 10},
+};
+#define BLANK_DRIVER_COUNT (sizeof(BLANK_DRIVERS) / sizeof(BLANK_DRIVERS[0]))
+#define BLANK_DRIVER_LEGACY (BLANK_DRIVER_COUNT - 1)  //Used when the auto-probe can't tell the blank type
+
+//Dallas / Maxim CRC8 (x^8 + x^5 + x^4 + 1) lookup table, generated by the compiler.
+constexpr byte crc8_shift(byte crc) { return (crc & 1) ? (crc >> 1) ^ 0x8C : crc >> 1; }
+constexpr byte crc8_entry(byte x) {
+  return crc8_shift(crc8_shift(crc8_shift(crc8_shift(crc8_shift(crc8_shift(crc8_shift(crc8_shift(x))))))));
+}
+#define CRC8_ROW(x) crc8_entry(x), crc8_entry(x + 1), crc8_entry(x + 2), crc8_entry(x + 3), \
+                    crc8_entry(x + 4), crc8_entry(x + 5), crc8_entry(x + 6), crc8_entry(x + 7), \
+                    crc8_entry(x + 8), crc8_entry(x + 9), crc8_entry(x + 10), crc8_entry(x + 11), \
+                    crc8_entry(x + 12), crc8_entry(x + 13), crc8_entry(x + 14), crc8_entry(x + 15)
+PROGMEM const byte CRC8_TABLE[256] = {
+  CRC8_ROW(0x00), CRC8_ROW(0x10), CRC8_ROW(0x20), CRC8_ROW(0x30), CRC8_ROW(0x40), CRC8_ROW(0x50), CRC8_ROW(0x60), CRC8_ROW(0x70),
+  CRC8_ROW(0x80), CRC8_ROW(0x90), CRC8_ROW(0xA0), CRC8_ROW(0xB0), CRC8_ROW(0xC0), CRC8_ROW(0xD0), CRC8_ROW(0xE0), CRC8_ROW(0xF0),
+};
+static_assert(crc8_entry(0x01) == 0x5E && crc8_entry(0x80) == 0x8C, "CRC8 table generator is broken");
+
+byte crc8(const byte data[], byte len) { //Same result as OneWire::crc8(), one table lookup per Byte
+  byte crc = 0;
+  while (len--) {
+    crc = pgm_read_byte(&CRC8_TABLE[crc ^ *data++]);
+  }
+  return crc;
+}
+
+#if USE_TRACE == true
+/* Trace recording ('T'), for reproducing & profiling a session offline. While it's on, the serial input (when it arrived &
+ * what was read), every 1-Wire bus operation, the programming pulses of writeByte() & every EEPROM write are sent as binary
+ * records in the console output:
+ *   TRACE_MARKER, type, microseconds since the previous record (LEB128: 7 bits per Byte, LSB first, top bit = more follows), payload
+ * The payload length is fixed per type. A TRACE_MARKER in the console text (slot names, macros & echoed input can hold any Byte)
+ * is sent as TRACE_MARKER, TRACE_ESCAPE meanwhile, so a TRACE_MARKER followed by a type always starts a record.
+ * Records go through the console queue like the text, a record that doesn't fit while the output is held is dropped whole
+ * & counted in a TRACE_LOST record. tools/trace decodes the capture & replays its serial input to a device, the host build
+ * (test/host) replays the whole session deterministically from it.
+ */
+#define TRACE_MARKER 0xF5
+#define TRACE_ESCAPE 0x00         //After a TRACE_MARKER: it was a text Byte
+#define TRACE_VERSION 2
+#define TRACE_START 0x01          //Record types, payload: TRACE_VERSION, micros() at the start (LSB first)
+#define TRACE_SERIAL_IN 0x02      //Byte read from the serial port
+#define TRACE_BUS_RESET 0x03      //pin, presence
+#define TRACE_BUS_WRITE 0x04      //pin, Byte
+#define TRACE_BUS_READ 0x05       //pin, Byte
+#define TRACE_BUS_WRITE_BIT 0x06  //pin, bit
+#define TRACE_BUS_READ_BIT 0x07   //pin, bit
+#define TRACE_BUS_SEARCH 0x08     //pin, found, ROM (8 Bytes, zeroes if not found)
+#define TRACE_PULSES 0x09         //pin, Byte as pulsed by writeByte() (after the bit inversion), LSB first
+#define TRACE_EEPROM_WRITE 0x0A   //address (LSB first), Byte
+#define TRACE_LOST 0x0B           //Records dropped before this one (LSB first)
+#define TRACE_STOP 0x0C           //No payload
+#define TRACE_SERIAL_RX 0x0D      //Bytes the serial port received since it was last looked at, they're read later
+
+bool traceOn = false;
+void trace_record(byte type, const byte payload[], byte len); //Records are a part of the console output, see below
+
+class TracedOneWire : public OneWire { //OneWire that adds every operation the firmware does on the bus to the trace
+public:
+  TracedOneWire(byte pin) : OneWire(pin), busPin(pin) {}
+  uint8_t reset() {
+    uint8_t presence = OneWire::reset();
+    trace_bus(TRACE_BUS_RESET, presence);
+    return presence;
+  }
+  void write(uint8_t v, uint8_t power = 0) {
+    OneWire::write(v, power);
+    trace_bus(TRACE_BUS_WRITE, v);
+  }
+  uint8_t read() {
+    uint8_t v = OneWire::read();
+    trace_bus(TRACE_BUS_READ, v);
+    return v;
+  }
+  void write_bit(uint8_t v) {
+    OneWire::write_bit(v);
+    trace_bus(TRACE_BUS_WRITE_BIT, v);
+  }
+  uint8_t read_bit() {
+    uint8_t v = OneWire::read_bit();
+    trace_bus(TRACE_BUS_READ_BIT, v);
+    return v;
+  }
+  void select(const uint8_t rom[8]) { //Match ROM, the same as OneWire::select(), just through the traced write()
+    write(0x55);
+    for (byte x = 0; x < 8; x++) write(rom[x]);
+  }
+  void skip() {
+    write(0xCC);
+  }
+  bool search(uint8_t *newAddr, bool search_mode = true) {  //Traced as a whole, not bit by bit
+    bool found = OneWire::search(newAddr, search_mode);
+    byte payload[10] = {busPin, found};
+    if (found) memcpy(payload + 2, newAddr, 8);
+    trace_record(TRACE_BUS_SEARCH, payload, sizeof(payload));
+    return found;
+  }
+private:
+  void trace_bus(byte type, byte value) {
+    byte payload[2] = {busPin, value};
+    trace_record(type, payload, sizeof(payload));
+  }
+  byte busPin;
+};
+typedef TracedOneWire OneWireBus;
+#else
+typedef OneWire OneWireBus;
+#endif
+
+OneWireBus ibutton(IBUTTON);
+
+#if USE_MULTI_PROBE == true
+const byte probePin[] = {PROBE_PINS};
+OneWireBus probeBus[] = {PROBE_PINS};    //One bus per contact, the first one shares the pin with ibutton
+#define PROBE_COUNT (sizeof(probePin) / sizeof(probePin[0]))
+
+#define PROBE_IDLE 0        //Nothing on the contacts
+#define PROBE_PRESENT 1     //A blank was detected, waiting for the next write batch
+#define PROBE_WRITING 2
+#define PROBE_VERIFYING 3
+#define PROBE_DONE 4        //Written & verified, waiting for removal
+#define PROBE_FAILED 5      //Verify failed, waiting for removal
+
+struct Probe {
+  byte state;
+  byte driver;              //BLANK_DRIVERS index, picked when the blank is detected
+  unsigned int written, failed;
+};
+Probe probes[PROBE_COUNT];
+#endif
 
 // void(* resetFunc) (void) = 0; //declare reset function @ memory address 0, essentially reseting the whole program, without rebooting the MCU itself. SEE: https://forum.arduino.cc/t/reset-command/12939/14
 void(* resetFunc) (void) = &setup; //declare reset function @ memory address 0, essentially reseting the whole program, without rebooting the MCU itself. SEE: https://forum.arduino.cc/t/reset-command/12939/14
@@ -97,914 +310,2891 @@ void(* resetFunc) (void) = &setup; //declare reset function @ memory address 0,
 byte addr[8]; //Buffer for address for iButton.search();
 byte code[8]; //Buffer for manipulations with address;
 bool read_pressed, write_pressed;
-int8_t serial_choice = -1; //0=show, 1=edit, 2=clear, 3=dump, 4=read iBtn, 5=write iBtn, 6=list iBtn, -1=none
 byte activeMemSlot = 0; //only lower nibble (first 4 bits of the byte) is used
 bool advancedMode = false;
+bool overdriveReads = false;  //Try overdrive speed first in search_iButton()
+bool readAtOverdrive = false; //Which speed the last search_iButton() used
+byte readSamples = 0;         //How many ROM samples the last search_iButton() took
+int8_t forcedBlankDriver = BLANK_DRIVER_LEGACY; //Index to BLANK_DRIVERS, -1 = auto-probe before every write (opt-in, the probe writes record flags)
+
+#define IDLE_BUSY 0         //Idle modes, used by idle_sleep()
+#define IDLE_SLEEP 1
+#define IDLE_POWER_DOWN 2
+byte idleMode = IDLE_SLEEP;
+
+struct PowerStats {         //Sleep bookkeeping, reported by the 'P' command
+  unsigned long sleeps;     //Number of times we went to sleep
+  unsigned long asleepUs;   //Time spent sleeping (estimated in POWER-DOWN, as the timers are stopped there)
+  unsigned long awakeUs;    //Time spent awake between sleeps
+  unsigned long entryUsSum; //Time spent preparing to sleep (arming wake sources, flushing serial...)
+  unsigned int entryUsMax;
+  unsigned long lastWakeUs; //micros() when we last woke up
+};
+PowerStats powerStats;
+unsigned long serialActiveAt = 0;   //millis() of the last serial input, see SERIAL_AWAKE_MS
+
+/* Slot selector. The SLOT[] switches are sampled in the background (slot_service(), from yield() & idle_sleep()),
+ * and a new position only counts once it has read the same SLOT_DEBOUNCE times in a row, so a rotary switch passing
+ * through the positions in between (or a bouncing contact) never selects them.
+ * activeMemSlot & code[] are the snapshot the operations work with. update_slot() pins it once at their start, so the
+ * selector can't change it half way through, and code[] is only reloaded from the EEPROM when slotVersion has moved,
+ * i.e. the selection or the content of a slot changed since it was loaded.
+ * SLOT[0] shares its pin with the WRITE button, so a WRITE press reads as bit 0 cleared. It's pinned at the press edge, before the
+ * debounce could take the press in: the write goes to the slot selected before it. The selection then follows the held button
+ * (SLOT_DEBOUNCE samples later) and comes back on release, which only reloads code[].
+ */
+#define SLOT_SAMPLE_MS 4          //Selector sampling period
+#define SLOT_DEBOUNCE 5           //Equal samples needed to accept a new position, ~20 ms
+
+byte selectorSlot = 0;            //Debounced selector position
+byte selectorRaw = 0;             //Last sample...
+byte selectorCount = 0;           //...and how many times in a row it was read
+unsigned long selectorSampled = 0;
+byte slotVersion = 1;             //Moves on every change of the selection or of a slot's EEPROM content
+byte codeVersion = 0;             //slotVersion code[] was loaded at, 0 = never
+
+byte read_slot_pins() {
+  byte value = 0;
+  for(byte x = 0; x < 4; x++) {
+    value |= digitalRead(pgm_read_word(&SLOT[x])) << x;
+  }
+  return value;
+}
 
-//TODO: Besides editing, allow copying memory slots...
-//TODO: Consolidate all memory operations, under some memory management submenu
+void slot_changed() { //Invalidates the snapshot. Call it after changing the selection or writing a slot's code to the EEPROM.
+  if (++slotVersion == 0) slotVersion = 1;
+}
 
-void printMenu() { //Serial menu...
-  S.println(F("===Welcome to iButton Cloner Serial Console==="));
-  S.println(F("Enter 'L' to LIST / detect / read connected iButton."));
-  S.println(F("Enter 'S' to SHOW contents of the currently active memory slot."));
-  S.println(F("Enter 'R' to READ FROM iButton to currently active memory slot."));
-  S.println(F("Enter 'W' to WRITE TO iButton from currently active memory slot."));
-  S.println(F("Enter 'V' to VERIFY iButton address against currently active memory slot."));
-  S.println(F("Enter 'E' to EDIT the currently active memory slot."));
-  S.println(F("Enter 'C' to CLEAR the currently active memory slot."));
-  S.println(F("Enter 'D' to DUMP all memory slots."));
-  S.println(F("Enter '|' (pipe) to stop code execution, until iButton is detected (allows for batch operation / command queuing)."));
-  S.println(F("Enter 'A' to enter / toggle ADVANCED options mode."));
-  if (advancedMode) {
-  S.println();
-  S.println(F("===Advanced commands==="));
-  S.println(F("Enter 'M' to change active memory slot."));
+void slot_init() {
+  selectorSlot = selectorRaw = read_slot_pins();
+  selectorCount = SLOT_DEBOUNCE;
+  selectorSampled = millis();
+}
+
+bool slot_settled() { //FALSE while a new selector position is being debounced
+  return selectorCount >= SLOT_DEBOUNCE;
+}
+
+void slot_service() {
+  if (millis() - selectorSampled < SLOT_SAMPLE_MS) return;
+  selectorSampled = millis();
+  byte raw = read_slot_pins();
+  if (raw != selectorRaw) {
+    selectorRaw = raw;
+    selectorCount = 1;
+    return;
+  }
+  if (selectorCount < SLOT_DEBOUNCE) selectorCount++;
+  if (slot_settled() && selectorSlot != raw) {
+    selectorSlot = raw;
+    slot_changed();
   }
-  S.println();
 }
 
-//TODO: Make serial_parser return serial_choice & feed it into other function supposed to run correct menu function...
-//TODO: Maybe make it output the character, or an int, and we can get rid of global serial_choice completely!
-void serial_parser() { 
-  delay(30);                          //wait for serial to catch up
-  byte currChar;
-  // while(Serial.available() > 0) {  //while data is left in the serial buffer
-  if(Serial.available() > 0) {        //Replaced the while above.
-    currChar = Serial.read();         //read (pop) a byte off the serial buffer
-    if(serial_choice == -1) {         //if so serial state is set to run
-      currChar = toupper(currChar);   //capitalize
-
-      switch (currChar) {
-      case 'S':           //SHOW command
-        serial_choice = 0;
-        break;
-      case 'E':           //WRITE command
-        serial_choice = 1;
-        break;
-      case 'C':           //CLEAR command
-        serial_choice = 2;
-        break;
-      case 'D':           //DUMP command
-        serial_choice = 3;
-        break;
-      case 'R':           //READ_FROM_IBUTTON command
-        serial_choice = 4;
-        break;
-      case 'W':           //WRITE_TO_IBUTTON command
-        serial_choice = 5;
-        break;
-      case 'L':           //LIST_IBUTTON command
-        serial_choice = 6;
-        break;
-      case '|':           //WAIT command
-        serial_choice = 7;
-        break;
-      case 'A':           //ADVANCED menu
-        serial_choice = 8;
-        break;
-      case 'M':           //MEMORY_SELECT menu
-        serial_choice = 9;
-        break;
-      case 'V':           //VERIFY command
-        serial_choice = 10;
-        break;
-      default:            //For easier adding of new characters.
-        SDBGprint("You have written: ");
-        SDBGprintln((char)currChar);
-        SDBGprintln(currChar, HEX);
-        SDBGprintln(currChar);
-        break;
+#define MACRO_ADDR 0x300          //Command macros EEPROM region, up to 0x3FF
+#define MACRO_COUNT 4
+#define MACRO_SIZE 64             //8 Bytes of name (like the slot names), then the command text, 0x00 terminated if shorter
+#define MACRO_TEXT (MACRO_SIZE - 8)
+
+/* The console. Input is the running macro first, then the serial port - commands & their inputs read this, never Serial.
+ * Output goes to a RAM queue, moved to the serial port only as fast as it takes it without blocking, so printing never waits for the UART.
+ * hold() / release() wrap 1-Wire bus operations: nothing is moved to the serial port meanwhile, and if the queue fills up anyway,
+ * the output is dropped (and reported on release) rather than waited for. Console verbosity can't change the bus timing.
+ */
+class ConsoleStream : public Stream {
+public:
+  using Print::write;                     //Buffer writes, Byte by Byte through the queue
+  int available() override {
+    if (feeding()) return macroEnd - macroAddr;
+    return serial_available();
+  }
+  int read() override {
+    if (!feeding()) {
+      serial_available();
+      int c = Serial.read();
+      if (c >= 0) {
+        serialActiveAt = millis();
+        serialSeen--;
+      }
+#if USE_TRACE == true
+      if (c >= 0) {
+        byte b = c;
+        trace_record(TRACE_SERIAL_IN, &b, 1);
+      }
+#endif
+      return c;
+    }
+    byte c = EEPROM.read(macroAddr++);
+    if (macroAddr == macroEnd) macroAddr = 0;   //Macro done, back to the serial port
+    return c;
+  }
+  int peek() override {
+    if (feeding()) return EEPROM.read(macroAddr);
+    serial_available();
+    return Serial.peek();
+  }
+  size_t write(uint8_t c) override {
+#if USE_TRACE == true
+    if (c == TRACE_MARKER && traceOn) {   //Escaped, it would start a record otherwise
+      if (txHold > 0 && !room(2)) {
+        if (txDropped < 0xFFFF) txDropped++;
+        return 0;
       }
+      enqueue(TRACE_MARKER);
+      return enqueue(TRACE_ESCAPE);
     }
-  }                                   //END of reading from serial
+#endif
+    return enqueue(c);
+  }
+  void write_record(const byte record[], byte size) { //A trace record, as it is
+    for (byte x = 0; x < size; x++) enqueue(record[x]);
+  }
+  void flush() override {                 //Waits until everything is sent
+    while (txHead != txTail) {
+      if (txHold > 0) {
+        drain();                          //Held: neither the interrupt nor pump() drains now, it would never empty otherwise
+      } else {
+        pump();
+      }
+    }
+    Serial.flush();
+  }
+  void drain() {                          //Moves a burst of the queued output to the serial port, without blocking. Single consumer: the ISR, or pump().
+    int room = Serial.availableForWrite();
+    for (byte x = 0; x < CONSOLE_TX_BURST && x < room && txHead != txTail; x++) {
+      Serial.write(txBuf[txHead]);
+      txHead = (txHead + 1) & (CONSOLE_TX_QUEUE - 1);
+    }
+  }
+  void pump() {                           //Drains from the main code, unless the interrupt is doing it right now
+    if (txHold > 0) return;
+#if CONSOLE_TX_ISR == true
+    if ((SREG & _BV(SREG_I)) && (TIMSK0 & _BV(OCIE0A))) return;
+#endif
+    drain();
+  }
+  bool held() {
+    return txHold > 0;
+  }
+  bool room(byte n) {                     //TRUE if n more Bytes fit to the queue right now
+    return ((txHead - txTail - 1) & (CONSOLE_TX_QUEUE - 1)) >= n;
+  }
+  void hold() {                           //Critical section start, they can be nested
+    if (txHold == 0) {                    //Empty the queue first, so the output of the bus operation fits. The bus isn't in use yet.
+      while (txHead != txTail) pump();
+    }
+    txHold++;
+  }
+  void release() {
+    if (--txHold > 0) return;
+    if (txDropped > 0) {
+      unsigned int dropped = txDropped;
+      txDropped = 0;
+      print(F("[WARNING] Console output queue overflow, Bytes dropped: ")); println(dropped);
+    }
+  }
+  bool feeding() {                    //TRUE while a macro is running
+    return macroAddr != 0;
+  }
+  void stop() {
+    macroAddr = 0;
+  }
+  void run(unsigned int from, unsigned int to) {  //Feeds the EEPROM range as the next input
+    macroAddr = from < to ? from : 0;
+    macroEnd = to;
+  }
+  void settle(unsigned long ms) {     //Lets the rest of a typed / pasted input arrive. A macro has it all already, no need to wait.
+    if (!feeding()) delay(ms);
+  }
+private:
+  size_t enqueue(byte c) {
+    byte next = (txTail + 1) & (CONSOLE_TX_QUEUE - 1);
+    while (next == txHead) {              //Full
+      if (txHold > 0) {                   //Never wait in a critical section
+        if (txDropped < 0xFFFF) txDropped++;
+        return 0;
+      }
+      pump();
+    }
+    txBuf[txTail] = c;
+    txTail = next;                        //Only now the drain can see it
+    return 1;
+  }
+  int serial_available() {            //Serial.available(), noting the Bytes that arrived since the last look for the trace
+    int n = Serial.available();
+    if (n > serialSeen) {
+#if USE_TRACE == true
+      byte arrived = n - serialSeen;
+      trace_record(TRACE_SERIAL_RX, &arrived, 1);
+#endif
+      serialSeen = n;
+    }
+    return n;
+  }
+  int serialSeen = 0;                 //Bytes in the serial RX buffer serial_available() has seen
+  unsigned int macroAddr = 0;         //Next EEPROM Byte to feed, 0 = no macro running
+  unsigned int macroEnd = 0;
+  byte txBuf[CONSOLE_TX_QUEUE];
+  volatile byte txHead = 0;               //Next Byte to send, only the drain moves it
+  volatile byte txTail = 0;               //Next free place, only write() moves it
+  volatile byte txHold = 0;
+  unsigned int txDropped = 0;
+};
+ConsoleStream Console;
+
+struct ConsoleHold {                      //Holds the console output for the scope it's declared in
+  ConsoleHold() { Console.hold(); }
+  ~ConsoleHold() { Console.release(); }
+};
+
+#if CONSOLE_TX_ISR == true
+ISR(TIMER0_COMPA_vect) {                  //1 kHz, Timer0 is already running for millis()
+  if (!Console.held()) Console.drain();
 }
+#endif
 
-int writeByte(byte data) {
-  int data_bit;
-  for(data_bit=0; data_bit<8; data_bit++){
-    if (data & 1){
-      digitalWrite(IBUTTON, LOW); pinMode(IBUTTON, OUTPUT);
-      delayMicroseconds(60);
-      pinMode(IBUTTON, INPUT); digitalWrite(IBUTTON, HIGH);
-      delay(10);
-    } else {
-      digitalWrite(IBUTTON, LOW); pinMode(IBUTTON, OUTPUT);
-      pinMode(IBUTTON, INPUT); digitalWrite(IBUTTON, HIGH);
-      delay(10);
+void yield() {                            //delay() calls it while waiting
+  Console.pump();
+  slot_service();
+}
+
+#if USE_TRACE == true
+unsigned long traceLastUs;                //micros() of the last record sent
+unsigned int traceLost = 0;               //Records dropped since the last one sent
+
+bool trace_emit(byte type, const byte payload[], byte len) { //Queues one record as a whole. FALSE if it doesn't fit while the output is held.
+  unsigned long now = micros();
+  unsigned long delta = now - traceLastUs;
+  byte record[2 + 5 + 10];                //Marker, type, up to 5 Bytes of LEB128 delta, the longest payload (TRACE_BUS_SEARCH)
+  byte size = 0;
+  record[size++] = TRACE_MARKER;
+  record[size++] = type;
+  do {
+    record[size] = delta & 0x7F;
+    delta >>= 7;
+    if (delta) record[size] |= 0x80;
+    size++;
+  } while (delta);
+  memcpy(record + size, payload, len);
+  size += len;
+  if (Console.held() && !Console.room(size)) return false;
+  traceLastUs = now;
+  Console.write_record(record, size);
+  return true;
+}
+
+void trace_record(byte type, const byte payload[], byte len) {
+  if (!traceOn) return;
+  if (traceLost > 0) {
+    byte lost[2] = {lowByte(traceLost), highByte(traceLost)};
+    if (!trace_emit(TRACE_LOST, lost, sizeof(lost))) {
+      if (traceLost < 0xFFFF) traceLost++;
+      return;
     }
-    data = data >> 1;
+    traceLost = 0;
   }
-  return 0;
+  if (!trace_emit(type, payload, len) && traceLost < 0xFFFF) traceLost++;
 }
 
-void blinkPin(int LED, int cycles, int period) {
-  for(int i=0; i<cycles; i++) {
-    digitalWrite(LED, HIGH);
-    delay(period/2);
-    digitalWrite(LED, LOW);
-    delay(period/2);
-  }
+void trace_pulses(byte pin, byte value) {
+  byte payload[2] = {pin, value};
+  trace_record(TRACE_PULSES, payload, sizeof(payload));
 }
+#else
+void trace_pulses(byte pin, byte value) {}
+#endif
 
-void clear_serial() {
-#if USE_SERIAL == true
-  S.println(F("[WARNING] Clearing serial input. Any queued commands are lost now."));
-  while(Serial.available() > 0) {
-    // char a = Serial.read(); //unnecessary??
-    Serial.read();
-  }
+void eeprom_write(int addr, byte value) { //Every EEPROM write goes through these, so the trace sees them
+#if USE_TRACE == true
+  byte payload[3] = {lowByte(addr), highByte(addr), value};
+  trace_record(TRACE_EEPROM_WRITE, payload, sizeof(payload));
 #endif
+  EEPROM.write(addr, value);
 }
 
-void wait_for_serial_input() {  //While there is NO serial input... Wait... //TODO: should we add "timeout" parameter here?
-#if USE_SERIAL == true
-  while (Serial.available() < 1) {  //While there is NO serial input...
-    delay(1);                       //Wait...
-    yield();
-  }
-#endif
+void eeprom_update(int addr, byte value) {
+  if (EEPROM.read(addr) != value) eeprom_write(addr, value);
 }
 
-void bad_form() { //Called on some invalid serial input, not always though. Mainly fom edit_slot() function
-#if USE_SERIAL == true
-  Serial.flush();
-#endif
-  clear_serial();
-  S.println(F("[WARNING] Exiting from any functions to the main menu!"));
-  // delay(50);    //If there won't be this delay, the serial won't finisht printing & glitches out.
-  //TODO: The resetFunc() seems currently broken. I haven't found the reason yet, but it's unsupported way reset.
-  // resetFunc();  //When this runs, it appears, that it'll reset loop / end all functions. I'm not actually sure what's the purpose of this though...
+template <typename T> void eeprom_put(int addr, const T &value) {
+  const byte *data = (const byte *)&value;
+  for (byte x = 0; x < sizeof(T); x++) {
+    eeprom_update(addr + x, data[x]);
   }
+}
 
-int hex_digit_val_dec(char ch) {
-  int returnType;
-  switch(ch)
-  {
-    case '0':
-      returnType = 0;
-      break;
-    case  '1' :
-      returnType = 1;
-      break;
-    case  '2':
-      returnType = 2;
-      break;
-    case  '3':
-      returnType = 3;
-      break;
-    case  '4' :
-      returnType = 4;
-      break;
-    case  '5':
-      returnType = 5;
-      break;
-    case  '6':
-      returnType = 6;
-      break;
-    case  '7':
-      returnType = 7;
-      break;
-    case  '8':
-      returnType = 8;
-      break;
-    case  '9':
-      returnType = 9;
-      break;
-    case  'A':
-      returnType = 10;
-      break;
-    case  'B':
-      returnType = 11;
-      break;
-    case  'C':
-      returnType = 12;
-      break;
-    case  'D':
-      returnType = 13;
-      break;
-    case  'E':
-      returnType = 14;
-      break;
-    case  'F' :
-      returnType = 15;
-      break;
-    default:
-      returnType = -1;
-      break;
-  }
-  return returnType;
+#if USE_MEMORY_REPORT == true && defined(__AVR__)
+/* RAM high-water marks, for the 'H' report. All the RAM above the globals is painted with STACK_PAINT at boot,
+ * before anything runs, so the lowest Byte the stack has overwritten tells how deep it has ever been.
+ * STACK_PROBE() marks a function: it samples the heap size and keeps the deepest nesting of the probed functions seen.
+ */
+#define STACK_PAINT 0xC5
+#define STACK_PATH 8                      //Nesting of STACK_PROBE()s kept for the deepest call path
+
+extern uint8_t __data_start, __heap_start, __stack;  //Start of RAM, end of the globals, end of RAM (linker symbols)
+extern char *__brkval;                    //Top of the heap, NULL until the first malloc()
+
+void paint_stack() __attribute__((naked, used, section(".init3")));
+void paint_stack() {                      //Runs from the startup code, jumped to and not called, so no stack is in use yet
+  for (uint8_t *p = &__heap_start; p <= &__stack; p++) *p = STACK_PAINT;
 }
 
-int hexstr_to_int(String hex) {
-  int ret = 0;
-  if(hex.length() == 2) {
-    int temp = hex_digit_val_dec(toupper(hex[0]));
+uint8_t *heapPeak = &__heap_start;
+uint8_t *deepestSp = &__stack;
+PGM_P stackPath[STACK_PATH];              //PROGMEM labels of the probed functions currently running
+byte stackDepth = 0;
+PGM_P deepestPath[STACK_PATH];
+byte deepestDepth = 0;
 
-    if(temp == -1) {
-      return -1;
-    }
-    ret += temp * 16;
+uint8_t *heap_end() {
+  return __brkval ? (uint8_t *)__brkval : &__heap_start;
+}
 
-    temp = hex_digit_val_dec(toupper(hex[1]));
-    if(temp == -1) {
-      return -1;
+void sample_heap() {  //The heap peak is only sampled - at the STACK_PROBE()s & while idle, not on every malloc()
+  if (heap_end() > heapPeak) heapPeak = heap_end();
+}
+
+struct StackProbe {
+  StackProbe(PGM_P label) {
+    uint8_t *sp = (uint8_t *)SP;
+    sample_heap();
+    if (stackDepth < STACK_PATH) stackPath[stackDepth] = label;
+    stackDepth++;
+    if (sp < deepestSp) {
+      deepestSp = sp;
+      deepestDepth = stackDepth < STACK_PATH ? stackDepth : STACK_PATH;
+      memcpy(deepestPath, stackPath, deepestDepth * sizeof(PGM_P));
     }
-    ret += temp;
   }
-  else {
-    return -1;;
+  ~StackProbe() {
+    sample_heap();
+    stackDepth--;
   }
-  return ret;
+};
+#define STACK_PROBE(label) StackProbe stackProbe(PSTR(label))
+
+void print_memory_report() {
+  sample_heap();
+  uint8_t *sp = (uint8_t *)SP;
+  uint8_t *deepest = heapPeak;            //Lowest Byte the stack has ever written to
+  while (deepest < sp && *deepest == STACK_PAINT) deepest++;
+
+  S.print(F("[INFO] RAM: ")); S.print(&__stack - &__data_start + 1);
+  S.print(F(" Bytes, globals (.data + .bss): ")); S.print(&__heap_start - &__data_start); S.println(F(" Bytes"));
+  S.print(F("[INFO] Heap now / peak: ")); S.print(heap_end() - &__heap_start);
+  S.print(F(" / ")); S.print(heapPeak - &__heap_start); S.println(F(" Bytes (peak sampled at the probed functions & idle only)"));
+  S.print(F("[INFO] Stack now / peak: ")); S.print(&__stack - sp);
+  S.print(F(" / ")); S.print(&__stack - deepest + 1); S.println(F(" Bytes"));
+  S.print(F("[INFO] Free RAM now / least ever: ")); S.print(sp - heap_end());
+  S.print(F(" / ")); S.print(deepest - heapPeak); S.println(F(" Bytes"));
+  S.print(F("[INFO] Deepest probed call path: "));
+  for (byte x = 0; x < deepestDepth; x++) {
+    if (x > 0) S.print(F(" > "));
+    S.print((const __FlashStringHelper *)deepestPath[x]);
+  }
+  S.print(F(" (stack ")); S.print(&__stack - deepestSp); S.println(F(" Bytes at its entry)"));
 }
+#else
+#define STACK_PROBE(label)
+#endif
 
-void update_slot() {  //Make a memory slot active according to GPIO pins
-    if (!advancedMode) { //IF is in advanced mode, do not change activeMemSlot correspond to the GPIO pins state.
+//TODO: Besides editing, allow copying memory slots...
+//TODO: Consolidate all memory operations, under some memory management submenu
 
-    activeMemSlot = 0x00;
-    for(int x = 0; x < 4; x++) {
-      activeMemSlot = activeMemSlot | (digitalRead(SLOT[x]) << x);
-    }
+void write_bit_pulse(byte pin, bool bit, byte pulseUs) { //One programming pulse, the caller has to wait for the recovery afterwards
+  noInterrupts();               //An interrupt in the middle would stretch the pulse, and that can flip the bit
+  if (bit){
+    digitalWrite(pin, LOW); pinMode(pin, OUTPUT);
+    delayMicroseconds(pulseUs);
+    pinMode(pin, INPUT); digitalWrite(pin, HIGH);
+  } else {
+    digitalWrite(pin, LOW); pinMode(pin, OUTPUT);
+    pinMode(pin, INPUT); digitalWrite(pin, HIGH);
   }
-
-  for(int x = 0; x < 8; x++) {  //Update the global variable code to contain aporopriate data from the currently active memory slot.
-    code[x] = EEPROM.read(x + (activeMemSlot << 5));
-  } //CRITICAL FIXME THIS MUST BE RUN BEFORE WRITING AS THE WRITE FUNCTION DEPENDS ON IT ENTIRELY!!!
-    //MAKE IT SO THE WRITE ENSURES THE SLOT ISN'T EMPTY, AND SYNCES THIS GLOBAL VARIABLE JUST BEFORE WRITING!
-    //IDEALLY, THE WRITE FUNCTION WOULD GET THE DATA FROM THE CURRENTLY ACTIVE EEPROM SLOT COMPLETELY INDEPENDENTLY!!!
-    //MAKE SURE THE CODE ABOUT TO BE WRITTEN DOES MAKE SENSE AND DOESN'T START WITH ZERO BYTE!!!
+  interrupts();
 }
 
-bool set_active_mem_slot(char c) {  //If it's one of the valid numbers, change activeMemSlot
-  if (hex_digit_val_dec(c) != -1) {
-        activeMemSlot = hex_digit_val_dec(c);
-        return true;
+int writeByte(byte pin, byte data, const BlankDriver &driver) {
+  if (driver.invertBits) data = ~data;
+  trace_pulses(pin, data);
+  int data_bit;
+  for(data_bit=0; data_bit<8; data_bit++){
+    write_bit_pulse(pin, data & 1, driver.pulseUs);
+    delay(driver.recoveryMs);
+    data = data >> 1;
   }
-  return false;
+  return 0;
 }
 
-bool slot_is_full(byte memSlot) { //Check whether the given memory slot contains saved (any) data
-  byte result = 0x00;
-  for(int x = 0; x < 8; x++) {
-    result = result | EEPROM.read(x + (memSlot << 5));
-  }
-  if(result == 0x00) {
-    return false;
-  }
-  else {
-    return true;
+void blinkPin(int LED, int cycles, int period) {
+  for(int i=0; i<cycles; i++) {
+    digitalWrite(LED, HIGH);
+    delay(period/2);
+    digitalWrite(LED, LOW);
+    delay(period/2);
   }
 }
 
-bool serial_parse_hex(int result[], uint8_t arraySize) {  //Reads hex values from serial in "0x01, 0x02, 0x03, ..." format. 
+#if USE_EMULATION == true && defined(__AVR__)
+/* DS1990A slave emulation. The whole slave lives in the pin change interrupt of the IBUTTON pin:
+ * every falling edge is either a reset, a master write slot (we time how long the master holds the line low),
+ * or a master read slot (we hold the line low for a while to answer 0). A read slot is timed after the answer too,
+ * as the master may reset in the middle of the ROM bits.
+ * Timing is measured with Timer0 directly, whose interrupts (millis, console drain) are disabled meanwhile to cut the jitter.
+ * Tested timing budget is for 16 MHz, 8 MHz boards are marginal in the read slots. test/host checks the state machine.
+ */
+#define EMU_TICKS(us) ((uint8_t)((us) * (F_CPU / 1000000UL) / 64))  //Timer0 runs at F_CPU / 64
+
+#define EMU_IDLE 0          //Ignore everything until the next reset
+#define EMU_COMMAND 1       //Receiving ROM command
+#define EMU_SEND_BIT 2      //Read ROM, sending the ROM bits
+#define EMU_SEARCH_BIT 3    //Search ROM, sending the bit...
+#define EMU_SEARCH_CMP 4    //...its complement...
+#define EMU_SEARCH_DIR 5    //...and receiving the direction the master took
+
+volatile bool emulationActive = false;
+volatile byte emuState = EMU_IDLE;
+volatile byte emuBit;       //Bit index into the command / ROM
+volatile byte emuCommand;
+volatile unsigned int emuResets, emuReads, emuSearches;
+byte emuRom[8];
+volatile uint8_t *emuInReg, *emuModeReg;
+uint8_t emuMask;
+byte emuTimerInterrupts;    //TIMSK0 to restore when the emulation stops
+
+static inline bool emu_rom_bit(byte i) {
+  return (emuRom[i >> 3] >> (i & 7)) & 1;
+}
 
-  // int amount = sizeof(result) / sizeof(result[0]);  //We can't do this :( We must pass the size as parameter...
+ISR(PCINT0_vect) {          //Wakes the MCU from sleep, and is the whole 1-Wire slave while the emulation is running
+  if (!emulationActive || (*emuInReg & emuMask)) return;   //Not emulating, or just a rising edge
+  uint8_t fell = TCNT0;
+  byte state = emuState;
+  bool reading = state == EMU_SEND_BIT || state == EMU_SEARCH_BIT || state == EMU_SEARCH_CMP;
+  bool bit;
+
+  if (reading) {                          //Master read slot, answer it right away
+    bit = emu_rom_bit(emuBit);
+    if (state == EMU_SEARCH_CMP) bit = !bit;
+    if (!bit) {
+      *emuModeReg |= emuMask;             //PORT bit is 0, so output means pulling the line low
+      delayMicroseconds(30);
+      *emuModeReg &= ~emuMask;
+    }
+  }
 
-  /* When you use a name of the array as an argument in a function call, 
-  the compiler treats it as a pointer whose value is the address of the first element of the array, 
-  using pointer notation or using array notation.
+  while (!(*emuInReg & emuMask)) {        //How long is the line held low? Write slot, read slot or reset.
+    if ((uint8_t)(TCNT0 - fell) > EMU_TICKS(900)) break;
+  }
+  uint8_t low = TCNT0 - fell;
+  PCIFR = _BV(PCIF0);                     //Forget the edges we made ourselves
+
+  if (low >= EMU_TICKS(400)) {            //Reset, in any state. Answer with a presence pulse.
+    delayMicroseconds(20);
+    *emuModeReg |= emuMask;
+    delayMicroseconds(120);
+    *emuModeReg &= ~emuMask;
+    emuState = EMU_COMMAND;
+    emuBit = 0;
+    emuCommand = 0;
+    emuResets++;
+    PCIFR = _BV(PCIF0);
+    return;
+  }
 
-  The function can use the value of that pointer to access (read and/or write) any element in the array.
+  if (reading) {
+    if (state == EMU_SEND_BIT) {
+      if (++emuBit == 64) {
+        emuState = EMU_IDLE;
+        emuReads++;
+      }
+    } else {
+      emuState = (state == EMU_SEARCH_BIT) ? EMU_SEARCH_CMP : EMU_SEARCH_DIR;
+    }
+    return;
+  }
+
+  bit = low < EMU_TICKS(30);              //Short low is 1, long low is 0
+  if (state == EMU_COMMAND) {
+    if (bit) emuCommand |= 1 << emuBit;
+    if (++emuBit == 8) {
+      emuBit = 0;
+      if (emuCommand == 0x33 || emuCommand == 0x0F) {   //Read ROM (0x0F is the old DS1990 opcode)
+        emuState = EMU_SEND_BIT;
+      } else if (emuCommand == 0xF0) {                  //Search ROM
+        emuState = EMU_SEARCH_BIT;
+      } else {
+        emuState = EMU_IDLE;
+      }
+    }
+  } else if (state == EMU_SEARCH_DIR) {
+    if (bit != emu_rom_bit(emuBit)) {     //Master went the other way, we drop out until the next reset
+      emuState = EMU_IDLE;
+    } else if (++emuBit == 64) {
+      emuState = EMU_IDLE;
+      emuSearches++;
+    } else {
+      emuState = EMU_SEARCH_BIT;
+    }
+  }
+}
+#endif
+
+#if USE_LOW_POWER == true && defined(__AVR__)
+volatile bool watchdogWoke = false;
+
+ISR(WDT_vect) {             //Watchdog in interrupt-only mode, it just wakes us up.
+  watchdogWoke = true;
+}
+
+#if USE_EMULATION != true
+EMPTY_INTERRUPT(PCINT0_vect);   //Pin change interrupts only wake the MCU, the pins themselves are read in loop().
+#endif
+#if defined(PCINT1_vect)
+EMPTY_INTERRUPT(PCINT1_vect);
+#endif
+#if defined(PCINT2_vect)
+EMPTY_INTERRUPT(PCINT2_vect);
+#endif
+
+void pin_change_wake(byte pin, bool enable) { //Arms / disarms pin change interrupt on the given pin, if it has one.
+  volatile uint8_t *pcicr = digitalPinToPCICR(pin);
+  if (pcicr == 0) return;                     //Not every pin can wake us up (e.g. some of the slot pins on the Pro Micro)
+  volatile uint8_t *pcmsk = digitalPinToPCMSK(pin);
+  if (enable) {
+    *pcmsk |= _BV(digitalPinToPCMSKbit(pin));
+    *pcicr |= _BV(digitalPinToPCICRbit(pin));
+  } else {
+    *pcmsk &= ~_BV(digitalPinToPCMSKbit(pin));
+  }
+}
+
+void power_down_wake_sources(bool enable, bool watchdogTick) {  //Everything that should end the POWER-DOWN sleep
+  pin_change_wake(READ, enable);
+  pin_change_wake(WRITE, enable);
+  for(int x = 0; x < 4; x++) {
+    pin_change_wake(pgm_read_word(&SLOT[x]), enable);
+  }
+#if !defined(USBCON)
+  pin_change_wake(0, enable);                 //Serial RX. Input arriving while the oscillator starts up (~1 ms, up to ~11 Bytes at 115200 Bd) is lost.
+#endif
+
+  cli();
+  wdt_reset();
+  MCUSR &= ~_BV(WDRF);
+  WDTCSR = _BV(WDCE) | _BV(WDE);              //Timed sequence, allows changing the watchdog configuration
+  if (enable && watchdogTick) {
+    WDTCSR = _BV(WDIE) | _BV(WDP1) | _BV(WDP0); //Interrupt only (no reset), ~125 ms
+  } else {
+    WDTCSR = 0;
+  }
+  sei();
+}
+#endif
+
+/* Operation statistics, kept in EEPROM after the memory slots, so they survive power cycles & slot wipes.
+ * The counters are first collected in a small RAM batch and only added to the EEPROM once the device idles,
+ * so reads & writes never wait for the EEPROM (~3.3 ms per Byte), and repeated operations cost a single update.
+ * Up to STATS_FLUSH_MS of statistics can be lost on a power cut.
+ */
+#define STATS_ADDR 0x200          //Statistics EEPROM region, up to 0x2FF
+#define STATS_MAGIC 0x5A02        //Marks an initialized statistics block, change it whenever StatsBlock changes
+#define STATS_FAMILIES 6          //Family codes counted on their own, the last entry collects all the others
+#define STATS_FAMILY_OTHER 0xFF
+#define STATS_BATCH 12            //Pending counter updates buffered in RAM
+#define STATS_FLUSH_MS 30000UL    //Longest time the pending updates wait for the EEPROM
+#define STATS_NO_SLOT 0xFF        //Operations not tied to a memory slot (clone queue)
+
+#define STATS_READS 0             //Counters in OpStats, and the matching totals in StatsBlock, in the same order
+#define STATS_WRITES 1
+#define STATS_VERIFY_FAILS 2
+#define STATS_RETRIES 3
+#define STATS_BRICK_SUSPECTS 4
+
+struct __attribute__((packed)) OpStats {  //Counters kept for every slot & family code
+  uint16_t reads;
+  uint16_t writes;
+  uint8_t verifyFails;            //Single Bytes from here on, or 16 slots & STATS_FAMILIES wouldn't fit to the region
+  uint8_t retries;
+  uint8_t brickSuspects;
+  uint8_t writeMsSum[3];          //Average write latency = writeMsSum / writes, 24 bits are 4.6 hours of writing
+};
+static_assert(offsetof(OpStats, verifyFails) == STATS_VERIFY_FAILS * sizeof(uint16_t) &&
+              offsetof(OpStats, brickSuspects) == STATS_BRICK_SUSPECTS + STATS_VERIFY_FAILS, "stats_count() expects this OpStats layout");
+struct __attribute__((packed)) FamilyStats {
+  byte family;                    //0x00 = free entry
+  OpStats ops;
+};
+struct __attribute__((packed)) StatsBlock { //EEPROM layout, only its offsets are used, it's never loaded to RAM as a whole
+  uint16_t magic;
+  uint32_t reads;
+  uint32_t writes;
+  uint32_t verifyFails;
+  uint32_t retries;               //Extra ROM samples the reads needed, see search_iButton()
+  uint32_t brickSuspects;         //Blanks that didn't answer anymore after a write
+  OpStats slot[16];
+  FamilyStats family[STATS_FAMILIES];
+};
+static_assert(STATS_ADDR + sizeof(StatsBlock) <= 0x300, "StatsBlock doesn't fit to its EEPROM region");
+
+#define STATS_AT(member) (STATS_ADDR + offsetof(StatsBlock, member))
+
+struct StatsDelta {               //One pending counter update
+  unsigned int addr;              //EEPROM address of the counter
+  byte size;                      //1 to 4 Bytes
+  unsigned int delta;
+};
+StatsDelta statsBatch[STATS_BATCH];
+byte statsPending = 0;
+unsigned long statsSince;         //millis() of the oldest pending update
+
+void stats_init() { //Zeroes the statistics, if the EEPROM region doesn't hold them yet
+  uint16_t magic;
+  if (EEPROM.get(STATS_ADDR, magic) == STATS_MAGIC) return;
+  for (unsigned int x = 0; x < sizeof(StatsBlock); x++) {
+    eeprom_update(STATS_ADDR + x, 0x00);
+  }
+  eeprom_update(STATS_AT(family) + (STATS_FAMILIES - 1) * sizeof(FamilyStats), STATS_FAMILY_OTHER);
+  eeprom_put(STATS_ADDR, (uint16_t)STATS_MAGIC);
+}
+
+uint32_t stats_get(unsigned int addr, byte size) {  //A counter of 1 to 4 Bytes, little endian
+  uint32_t value = 0;
+  for (byte x = size; x > 0; x--) value = (value << 8) | EEPROM.read(addr + x - 1);
+  return value;
+}
+
+void stats_flush() {  //Adds the pending updates to the EEPROM counters
+  STACK_PROBE("stats_flush");
+  for (byte x = 0; x < statsPending; x++) {
+    StatsDelta &d = statsBatch[x];
+    uint32_t value = stats_get(d.addr, d.size), max = 0xFFFFFFFFUL >> (32 - 8 * d.size);
+    value = d.delta > max - value ? max : value + d.delta;  //Saturate, don't wrap around
+    for (byte b = 0; b < d.size; b++, value >>= 8) eeprom_update(d.addr + b, (byte)value);
+  }
+  statsPending = 0;
+}
+
+void stats_service() {  //Called when idle, flushes the batch once it's old or getting full
+  if (statsPending > 0 && (statsPending >= STATS_BATCH / 2 || millis() - statsSince >= STATS_FLUSH_MS)) stats_flush();
+}
+
+void stats_add(unsigned int addr, byte size, unsigned int delta) {  //Queues a counter update, RAM only
+  if (delta == 0) return;
+  for (byte x = 0; x < statsPending; x++) {   //The same counter again, merge it to a single update
+    if (statsBatch[x].addr == addr && statsBatch[x].delta <= 0xFFFF - delta) {
+      statsBatch[x].delta += delta;
+      return;
+    }
+  }
+  if (statsPending == STATS_BATCH) stats_flush(); //Busy for long, without idling in between
+  if (statsPending == 0) statsSince = millis();
+  statsBatch[statsPending++] = {addr, size, delta};
+}
+
+unsigned int stats_slot_addr(byte slot) {
+  return STATS_AT(slot) + slot * sizeof(OpStats);
+}
+
+byte stats_family_at(unsigned int entry) { //Family code of the entry, a claim still in the batch included
+  for (byte x = 0; x < statsPending; x++) {
+    if (statsBatch[x].addr == entry) return statsBatch[x].delta;
+  }
+  return EEPROM.read(entry);
+}
+
+unsigned int stats_family_addr(byte family) { //Counters of the family code. A new family code claims a free entry.
+  byte x = family == 0x00 ? STATS_FAMILIES - 1 : 0;  //0x00 isn't a family code, it marks the free entries
+  for (; x < STATS_FAMILIES - 1; x++) {
+    unsigned int entry = STATS_AT(family) + x * sizeof(FamilyStats);
+    byte stored = stats_family_at(entry);
+    if (stored == family) break;
+    if (stored == 0x00) {
+      stats_add(entry, 1, family);  //Once per family code ever. Free entries are 0x00, adding the family code claims it.
+      break;
+    }
+  }
+  return STATS_AT(family) + x * sizeof(FamilyStats) + offsetof(FamilyStats, ops);
+}
+
+void stats_count(byte counter, byte slot, byte family, unsigned int n = 1) {  //n more of a STATS_* counter, family 0x00 = not known
+  byte at = counter < STATS_VERIFY_FAILS ? counter * sizeof(uint16_t) : counter + STATS_VERIFY_FAILS;  //See OpStats
+  byte size = counter < STATS_VERIFY_FAILS ? sizeof(uint16_t) : 1;
+  if (n == 0) return;                 //Don't claim a family entry for nothing
+  stats_add(STATS_AT(reads) + counter * sizeof(uint32_t), 4, n);
+  if (slot < 16) stats_add(stats_slot_addr(slot) + at, size, n);
+  if (family != 0x00) stats_add(stats_family_addr(family) + at, size, n);
+}
+
+void stats_write(byte slot, byte family, unsigned long ms, bool present) {  //A finished write, present = blank still answers
+  unsigned int latency = ms > 0xFFFF ? 0xFFFF : ms;
+  stats_count(STATS_WRITES, slot, family);
+  if (slot < 16) stats_add(stats_slot_addr(slot) + offsetof(OpStats, writeMsSum), sizeof(OpStats::writeMsSum), latency);
+  stats_add(stats_family_addr(family) + offsetof(OpStats, writeMsSum), sizeof(OpStats::writeMsSum), latency);
+  if (!present) stats_count(STATS_BRICK_SUSPECTS, slot, family);
+}
+
+void print_op_stats(unsigned int addr) {  //One OpStats line, without the heading
+  OpStats ops;
+  EEPROM.get(addr, ops);
+  S.print(F("reads: ")); S.print(ops.reads);
+  S.print(F(", writes: ")); S.print(ops.writes);
+  S.print(F(", verify failures: ")); S.print(ops.verifyFails);
+  S.print(F(", read retries: ")); S.print(ops.retries);
+  S.print(F(", suspected bricked: ")); S.print(ops.brickSuspects);
+  if (ops.writes > 0) {
+    S.print(F(", avg write: ")); S.print(stats_get(addr + offsetof(OpStats, writeMsSum), sizeof(ops.writeMsSum)) / ops.writes); S.print(F(" ms"));
+  }
+  S.println();
+}
+
+bool op_stats_used(unsigned int addr) {
+  OpStats ops;
+  EEPROM.get(addr, ops);
+  return ops.reads > 0 || ops.writes > 0 || ops.verifyFails > 0 || ops.retries > 0;
+}
+
+void print_stats() {  //Totals, then every slot & family code that was used at least once
+  STACK_PROBE("print_stats");
+  stats_flush();
+  uint32_t value;
+  S.print(F("[INFO] Reads: ")); S.print(EEPROM.get(STATS_AT(reads), value));
+  S.print(F(", writes: ")); S.print(EEPROM.get(STATS_AT(writes), value));
+  S.print(F(", verify failures: ")); S.println(EEPROM.get(STATS_AT(verifyFails), value));
+  S.print(F("[INFO] Read retries: ")); S.print(EEPROM.get(STATS_AT(retries), value));
+  S.print(F(", suspected bricked blanks: ")); S.println(EEPROM.get(STATS_AT(brickSuspects), value));
+  for (byte slot = 0; slot < 16; slot++) {
+    if (!op_stats_used(stats_slot_addr(slot))) continue;
+    S.print(F("Slot ")); S.print(slot, HEX); S.print(F(" : "));
+    print_op_stats(stats_slot_addr(slot));
+  }
+  for (byte x = 0; x < STATS_FAMILIES; x++) {
+    unsigned int entry = STATS_AT(family) + x * sizeof(FamilyStats);
+    byte family = EEPROM.read(entry);
+    if (family == 0x00 || !op_stats_used(entry + offsetof(FamilyStats, ops))) continue;
+    if (family == STATS_FAMILY_OTHER) {
+      S.print(F("Family OTHER : "));
+    } else {
+      S.print(F("Family 0x")); if (family < 0x10) {S.print("0");} S.print(family, HEX); S.print(F(" : "));
+    }
+    print_op_stats(entry + offsetof(FamilyStats, ops));
+  }
+}
+
+/* Audit journal of the clone operations - a ring of 8 Byte entries, in the unused upper 16 Bytes of every slot's 32 Byte stride:
+ *   0: op (bits 7-6) | OK (bit 5) | first since power-up (bit 4) | slot (bits 3-0)
+ *   1: sequence number, the newest entry is the one not followed by its successor
+ *   2-3: time since the previous entry - ms, or seconds when bit 15 is set (since power-up for the first entry)
+ *   4-6: 24-bit hash of the whole ID, see journal_hash()
+ *   7: CRC8 of Bytes 0-6 ^ JOURNAL_CRC_XOR, a torn or erased (0xFF or 0x00) entry doesn't pass it
+ * Appends only go to a RAM queue, the EEPROM gets one Byte per idle_sleep() call (when it isn't busy), so a clone cycle never waits for it.
+ */
+#define JOURNAL_ENTRIES 32        //2 per slot
+#define JOURNAL_QUEUE 4           //Entries waiting in RAM to be written
+#define JOURNAL_READ 0            //Operations
+#define JOURNAL_WRITE 1
+#define JOURNAL_VERIFY 2
+#define JOURNAL_QUEUE_WRITE 3     //Clone queue write, not tied to a slot
+#define JOURNAL_OK 0x20
+#define JOURNAL_BOOT 0x10
+#define JOURNAL_CRC_XOR 0x5A
+
+PROGMEM const char JOURNAL_OP_NAMES[][7] = {"READ", "WRITE", "VERIFY", "QUEUE"};
+
+byte journalQueue[JOURNAL_QUEUE][8];
+byte journalQueued = 0, journalQueueHead = 0;
+byte journalByte = 0;             //Next Byte of the oldest queued entry to write
+byte journalNext = 0;             //Entry index the next append goes to
+byte journalSeq = 0;              //Sequence number of the next append
+bool journalBooted = false;       //Something was logged since power-up
+unsigned long journalLast;        //millis() of the last append
+
+unsigned int journal_addr(byte entry) {
+  return ((entry >> 1) << 5) + 16 + (entry & 1) * 8;
+}
+
+bool journal_load(byte entry, byte data[8]) { //FALSE for erased / torn entries
+  for (byte x = 0; x < 8; x++) {
+    data[x] = EEPROM.read(journal_addr(entry) + x);
+  }
+  return (crc8(data, 7) ^ JOURNAL_CRC_XOR) == data[7];
+}
+
+void journal_init() { //Finds where the journal continues after a reset: just after the newest entry.
+                      //The valid entries' sequence numbers are less than JOURNAL_ENTRIES apart, the newest is the one no other
+                      //is ahead of - a corrupted entry in the middle of the ring doesn't end it there.
+  byte data[8];
+  int8_t newest = -1;
+  byte newestSeq = 0;
+  for (byte x = 0; x < JOURNAL_ENTRIES; x++) {
+    if (!journal_load(x, data)) continue;
+    if (newest < 0 || (byte)(data[1] - newestSeq) < 0x80) {
+      newest = x;
+      newestSeq = data[1];
+    }
+  }
+  if (newest >= 0) {
+    journalNext = (newest + 1) % JOURNAL_ENTRIES;
+    journalSeq = newestSeq + 1;
+  }
+}
+
+uint32_t journal_hash(const byte id[8]) { //FNV-1a, folded to 24 bits
+  uint32_t hash = 0x811C9DC5UL;
+  for (byte x = 0; x < 8; x++) {
+    hash = (hash ^ id[x]) * 16777619UL;
+  }
+  return (hash ^ (hash >> 24)) & 0xFFFFFFUL;
+}
+
+void journal_write_byte() { //Writes the next Byte of the oldest queued entry to the EEPROM
+  byte *entry = journalQueue[journalQueueHead];
+  byte target = (journalNext + JOURNAL_ENTRIES - journalQueued) % JOURNAL_ENTRIES;
+  eeprom_update(journal_addr(target) + journalByte, entry[journalByte]);
+  if (++journalByte == 8) {
+    journalByte = 0;
+    journalQueueHead = (journalQueueHead + 1) % JOURNAL_QUEUE;
+    journalQueued--;
+  }
+}
+
+void journal_service() {  //Called when idle, one Byte at a time, only if the EEPROM isn't busy writing the previous one
+  if (journalQueued > 0 && eeprom_is_ready()) journal_write_byte();
+}
+
+void journal_flush() {
+  while (journalQueued > 0) journal_write_byte();
+}
+
+void journal_append(byte op, byte slot, bool ok, const byte id[8]) {  //Logs one operation, RAM only
+  if (journalQueued == JOURNAL_QUEUE) {   //Not idle for a while, finish the oldest entry now - at most 8 Bytes
+    while (journalQueued == JOURNAL_QUEUE) journal_write_byte();
+  }
+  unsigned long now = millis();
+  unsigned long dt = journalBooted ? now - journalLast : now;
+  unsigned int delta = dt < 0x8000UL ? dt : (dt / 1000UL < 0x7FFFUL ? dt / 1000UL : 0x7FFF) | 0x8000;
+  uint32_t hash = journal_hash(id);
+
+  byte *entry = journalQueue[(journalQueueHead + journalQueued) % JOURNAL_QUEUE];
+  entry[0] = (op << 6) | (ok ? JOURNAL_OK : 0) | (journalBooted ? 0 : JOURNAL_BOOT) | (slot & 0x0F);
+  entry[1] = journalSeq++;
+  entry[2] = delta & 0xFF;
+  entry[3] = delta >> 8;
+  entry[4] = hash & 0xFF;
+  entry[5] = (hash >> 8) & 0xFF;
+  entry[6] = hash >> 16;
+  entry[7] = crc8(entry, 7) ^ JOURNAL_CRC_XOR;
+  journalQueued++;
+  journalNext = (journalNext + 1) % JOURNAL_ENTRIES;
+  journalBooted = true;
+  journalLast = now;
+}
+
+void print_journal() {  //CSV export, oldest entry first. The full ID is added while the slot still holds the logged one.
+  STACK_PROBE("print_journal");
+  journal_flush();
+  S.println(F("[JOURNAL] seq,boot,dt_ms,op,slot,result,id_hash,id"));
+  byte data[8];
+  byte count = 0;
+  for (byte x = 0; x < JOURNAL_ENTRIES; x++) {
+    byte entry = (journalNext + x) % JOURNAL_ENTRIES;
+    if (!journal_load(entry, data)) continue;
+    byte op = data[0] >> 6;
+    byte slot = data[0] & 0x0F;
+    unsigned int delta = data[2] | (data[3] << 8);
+    uint32_t hash = data[4] | ((uint32_t)data[5] << 8) | ((uint32_t)data[6] << 16);
+
+    S.print(data[1]); S.print(',');
+    S.print(data[0] & JOURNAL_BOOT ? 1 : 0); S.print(',');
+    S.print(delta & 0x8000 ? (delta & 0x7FFFUL) * 1000UL : delta); S.print(',');
+    S.print((const __FlashStringHelper *)JOURNAL_OP_NAMES[op]); S.print(',');
+    if (op == JOURNAL_QUEUE_WRITE) {
+      S.print('-');
+    } else {
+      S.print(slot, HEX);
+    }
+    S.print(data[0] & JOURNAL_OK ? F(",OK,") : F(",FAIL,"));
+    for (int8_t shift = 20; shift >= 0; shift -= 4) {
+      S.print((byte)(hash >> shift) & 0x0F, HEX);
+    }
+    S.print(',');
+    byte id[8];
+    for (byte i = 0; i < 8; i++) {
+      id[i] = EEPROM.read(i + (slot << 5));
+    }
+    if (op != JOURNAL_QUEUE_WRITE && journal_hash(id) == hash) {
+      for (byte i = 0; i < 8; i++) {
+        if (id[i] < 0x10) {S.print("0");}
+        S.print(id[i], HEX);
+      }
+    }
+    S.println();
+    count++;
+  }
+  S.print(F("[DONE] Entries: ")); S.println(count);
+}
+
+void idle_sleep(bool watchdogTick) {  //Wait for "something to happen" - as cheaply as the selected idleMode allows.
+                                      //watchdogTick = true, if the caller has to poll the 1-Wire bus even without any pin activity.
+  stats_service();
+  journal_service();
+  slot_service();
+  Console.pump();
+#if USE_MEMORY_REPORT == true && defined(__AVR__)
+  sample_heap();
+#endif
+#if USE_LOW_POWER == true && defined(__AVR__)
+  byte mode = idleMode;
+#if defined(USBCON)
+  if (mode == IDLE_POWER_DOWN) mode = IDLE_SLEEP; //POWER-DOWN would kill the USB serial, so IDLE is the deepest we can go there.
+#endif
+  if (mode == IDLE_POWER_DOWN && !slot_settled()) mode = IDLE_SLEEP; //Debouncing the selector needs millis() running
+#if !defined(USBCON)
+  if (mode == IDLE_POWER_DOWN && millis() - serialActiveAt < SERIAL_AWAKE_MS) mode = IDLE_SLEEP; //More serial input is likely to follow
+#endif
+  if (mode == IDLE_BUSY) {
+    delay(1);
+    yield();
+    return;
+  }
+
+  unsigned long entered = micros();
+  powerStats.awakeUs += entered - powerStats.lastWakeUs;
+
+  if (mode == IDLE_POWER_DOWN) {
+    stats_flush();                    //millis() stops in POWER-DOWN, so the STATS_FLUSH_MS flush wouldn't come before a power cut.
+    journal_flush();                  //Watchdog ticks are too rare to trickle it, and a RAM queue is lost on a power cut.
+    Console.flush();                  //USART is stopped in POWER-DOWN, finish sending first.
+    watchdogWoke = false;
+    power_down_wake_sources(true, watchdogTick);
+    set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+  } else {
+    set_sleep_mode(SLEEP_MODE_IDLE);  //Timer0 (millis) tick, serial RX and everything else still wakes us up within ~1 ms
+  }
+
+  cli();
+  sleep_enable();
+  unsigned long asleep = micros();
+  unsigned int entryUs = asleep - entered;
+  sei();                              //The instruction after sei() is always executed, so we can't miss the wake-up interrupt.
+  sleep_cpu();
+  sleep_disable();
+
+  unsigned long woke = micros();
+  if (mode == IDLE_POWER_DOWN) {
+    power_down_wake_sources(false, false);
+    powerStats.asleepUs += woke - asleep; //Timer0 is stopped, so we can only account for the watchdog period, if it was that what woke us up.
+    if (watchdogWoke) {
+      powerStats.asleepUs += WDT_TICK_MS * 1000UL;
+    } else {
+      serialActiveAt = millis();      //A pin change woke us up, maybe the serial RX. Whatever came meanwhile is lost, so stay reachable for the rest.
+    }
+  } else {
+    powerStats.asleepUs += woke - asleep;
+  }
+  powerStats.sleeps++;
+  powerStats.entryUsSum += entryUs;
+  if (entryUs > powerStats.entryUsMax) powerStats.entryUsMax = entryUs;
+  powerStats.lastWakeUs = woke;
+  if (powerStats.awakeUs > 0x7FFFFFFFUL || powerStats.asleepUs > 0x7FFFFFFFUL) {
+    powerStats.awakeUs >>= 1;         //Halve both before they overflow, the duty cycle ratio stays the same.
+    powerStats.asleepUs >>= 1;
+  }
+#else
+  delay(1);
+  yield();
+#endif
+}
+
+void print_power_stats() {  //Report the sleep latencies and duty cycle since the last idle mode change
+  S.print(F("[INFO] Idle mode: "));
+  if (idleMode == IDLE_BUSY) {
+    S.println(F("BUSY-wait (never sleeps)"));
+  } else if (idleMode == IDLE_SLEEP) {
+    S.println(F("IDLE sleep"));
+  } else {
+    S.println(F("POWER-DOWN sleep"));
+  }
+#if USE_LOW_POWER == true && defined(__AVR__)
+  S.print(F("[INFO] Sleeps: ")); S.println(powerStats.sleeps);
+  if (powerStats.sleeps > 0) {
+    S.print(F("[INFO] Sleep entry latency (avg / max): "));
+    S.print(powerStats.entryUsSum / powerStats.sleeps); S.print(F(" / ")); S.print(powerStats.entryUsMax); S.println(F(" us"));
+  }
+  S.print(F("[INFO] Sleep exit latency (estimated): "));
+  if (idleMode == IDLE_POWER_DOWN) {
+    S.print(16384UL * 1000UL / (F_CPU / 1000UL)); S.println(F(" us (16K CK oscillator start-up)"));
+  } else {
+    S.println(F("< 1 us (clock keeps running)"));
+  }
+  unsigned long total = powerStats.asleepUs + powerStats.awakeUs;
+  if (total > 0) {
+    S.print(F("[INFO] Estimated duty cycle (awake): "));
+    S.print(powerStats.awakeUs / (total / 100 + 1));
+    S.println(F(" %"));
+  }
+#if defined(USBCON)
+  S.println(F("[WARNING] USB serial board - POWER-DOWN falls back to IDLE sleep."));
+#endif
+#else
+  S.println(F("[WARNING] Sleep is not supported on this build, busy-waiting."));
+#endif
+}
+
+void clear_serial() {
+#if USE_SERIAL == true
+  S.println(F("[WARNING] Clearing serial input. Any queued commands are lost now."));
+  while(Console.available() > 0) {
+    // char a = Console.read(); //unnecessary??
+    Console.read();
+  }
+#endif
+}
+
+void wait_for_serial_input() {  //While there is NO serial input... Wait... //TODO: should we add "timeout" parameter here?
+#if USE_SERIAL == true
+  while (Console.available() < 1) {  //While there is NO serial input...
+    idle_sleep(false);              //Wait...
+  }
+#endif
+}
+
+void bad_form() { //Called on some invalid serial input, not always though. Mainly fom edit_slot() function
+#if USE_SERIAL == true
+  Console.flush();
+#endif
+  clear_serial();
+  S.println(F("[WARNING] Exiting from any functions to the main menu!"));
+  // delay(50);    //If there won't be this delay, the serial won't finisht printing & glitches out.
+  //TODO: The resetFunc() seems currently broken. I haven't found the reason yet, but it's unsupported way reset.
+  // resetFunc();  //When this runs, it appears, that it'll reset loop / end all functions. I'm not actually sure what's the purpose of this though...
+  }
+
+int hex_digit_val_dec(char ch) {
+  int returnType;
+  switch(ch)
+  {
+    case '0':
+      returnType = 0;
+      break;
+    case  '1' :
+      returnType = 1;
+      break;
+    case  '2':
+      returnType = 2;
+      break;
+    case  '3':
+      returnType = 3;
+      break;
+    case  '4' :
+      returnType = 4;
+      break;
+    case  '5':
+      returnType = 5;
+      break;
+    case  '6':
+      returnType = 6;
+      break;
+    case  '7':
+      returnType = 7;
+      break;
+    case  '8':
+      returnType = 8;
+      break;
+    case  '9':
+      returnType = 9;
+      break;
+    case  'A':
+      returnType = 10;
+      break;
+    case  'B':
+      returnType = 11;
+      break;
+    case  'C':
+      returnType = 12;
+      break;
+    case  'D':
+      returnType = 13;
+      break;
+    case  'E':
+      returnType = 14;
+      break;
+    case  'F' :
+      returnType = 15;
+      break;
+    default:
+      returnType = -1;
+      break;
+  }
+  return returnType;
+}
+
+int hexstr_to_int(String hex) {
+  STACK_PROBE("hexstr_to_int");
+  int ret = 0;
+  if(hex.length() == 2) {
+    int temp = hex_digit_val_dec(toupper(hex[0]));
+
+    if(temp == -1) {
+      return -1;
+    }
+    ret += temp * 16;
+
+    temp = hex_digit_val_dec(toupper(hex[1]));
+    if(temp == -1) {
+      return -1;
+    }
+    ret += temp;
+  }
+  else {
+    return -1;;
+  }
+  return ret;
+}
+
+void update_slot() {  //Pins the active memory slot snapshot (activeMemSlot & code[]) for the operation about to start
+  byte slot = advancedMode ? activeMemSlot : selectorSlot; //In advanced mode, the slot is selected via serial console ('M') instead of GPIO.
+  if (slot != activeMemSlot || codeVersion != slotVersion) {
+    activeMemSlot = slot;
+    for(int x = 0; x < 8; x++) {  //Update the global variable code to contain aporopriate data from the currently active memory slot.
+      code[x] = EEPROM.read(x + (activeMemSlot << 5));
+    }
+    codeVersion = slotVersion;
+  }
+}
+
+bool set_active_mem_slot(char c) {  //If it's one of the valid numbers, change activeMemSlot
+  if (hex_digit_val_dec(c) != -1) {
+        activeMemSlot = hex_digit_val_dec(c);
+        slot_changed();
+        return true;
+  }
+  return false;
+}
+
+bool code_is_full() { //slot_is_full() of the pinned snapshot, from code[] in RAM
+  byte result = 0x00;
+  for(byte x = 0; x < 8; x++) result |= code[x];
+  return result != 0x00;
+}
+
+bool slot_is_full(byte memSlot) { //Check whether the given memory slot contains saved (any) data
+  byte result = 0x00;
+  for(int x = 0; x < 8; x++) {
+    result = result | EEPROM.read(x + (memSlot << 5));
+  }
+  if(result == 0x00) {
+    return false;
+  }
+  else {
+    return true;
+  }
+}
+
+bool serial_parse_hex(int result[], uint8_t arraySize) {  //Reads hex values from serial in "0x01, 0x02, 0x03, ..." format. 
+  STACK_PROBE("serial_parse_hex");
+
+  // int amount = sizeof(result) / sizeof(result[0]);  //We can't do this :( We must pass the size as parameter...
+
+  /* When you use a name of the array as an argument in a function call, 
+  the compiler treats it as a pointer whose value is the address of the first element of the array, 
+  using pointer notation or using array notation.
+
+  The function can use the value of that pointer to access (read and/or write) any element in the array.
 
   Since the function has no way of knowing the size of the array unless you tell it, 
   the length of the array is commonly used as a parameter (in addition to the name of the array).
   https://forum.arduino.cc/t/passing-array-as-parameter/44562/3
   */
 
-  String hexstr[arraySize];
-  for(int x = 0; x < arraySize; x++) {                  ////sizeof(hexstr) / sizeof(hexstr[0]) will give back total number of Bytes, not array length.                        
-    byte justTheFirstOne = Serial.read();
-    if(justTheFirstOne != '0') {                          ////See https://www.arduino.cc/reference/en/language/variables/utilities/sizeof/#_notes_and_warnings
-      if (justTheFirstOne == 10 || justTheFirstOne == 13) { //if it has been just CR (10) or LF (13), then:
-        clear_serial();                                     //clear the serial input, (undesirable?)
-        return false;                                       //and return false.
-      }
-      S.println(F("[ERROR] No leading 0 found (before leading x).\n"));
-      SDBGprint(F("<DEBUG> You have written ")); SDBGprint(justTheFirstOne); SDBGprintln(F(" instead!"));
-      bad_form();
-      return false;
-    }
-    if(tolower(Serial.read()) != 'x') {
-      S.println(F("[ERROR] No leading x found (before 2 hex digits).\n"));
-      bad_form();
-      return false;
-    }
-    hexstr[x] = (char)Serial.read();
-    hexstr[x] += (char)Serial.read();
-    if(x < arraySize-1) {
-      if(Serial.read() != ',') {
-        S.println(F("[ERROR] No comma found between values (after 2 hex digits).\n"));
-        bad_form();
-      return false;
-      }
-      if(Serial.read() != ' ') {
-        S.println(F("[ERROR] No space found between values (after comma).\n"));
-        bad_form();
-      return false;
-      }
+  String hexstr[arraySize];
+  for(int x = 0; x < arraySize; x++) {                  ////sizeof(hexstr) / sizeof(hexstr[0]) will give back total number of Bytes, not array length.                        
+    byte justTheFirstOne = Console.read();
+    if(justTheFirstOne != '0') {                          ////See https://www.arduino.cc/reference/en/language/variables/utilities/sizeof/#_notes_and_warnings
+      if (justTheFirstOne == 10 || justTheFirstOne == 13) { //if it has been just CR (10) or LF (13), then:
+        clear_serial();                                     //clear the serial input, (undesirable?)
+        return false;                                       //and return false.
+      }
+      S.println(F("[ERROR] No leading 0 found (before leading x).\n"));
+      SDBGprint(F("<DEBUG> You have written ")); SDBGprint(justTheFirstOne); SDBGprintln(F(" instead!"));
+      bad_form();
+      return false;
+    }
+    if(tolower(Console.read()) != 'x') {
+      S.println(F("[ERROR] No leading x found (before 2 hex digits).\n"));
+      bad_form();
+      return false;
+    }
+    hexstr[x] = (char)Console.read();
+    hexstr[x] += (char)Console.read();
+    if(x < arraySize-1) {
+      if(Console.read() != ',') {
+        S.println(F("[ERROR] No comma found between values (after 2 hex digits).\n"));
+        bad_form();
+      return false;
+      }
+      if(Console.read() != ' ') {
+        S.println(F("[ERROR] No space found between values (after comma).\n"));
+        bad_form();
+      return false;
+      }
+    }
+  }
+
+  for(int x = 0; x < arraySize; x++) {
+    result[x] = hexstr_to_int(hexstr[x]);
+    if(result[x] == -1) {
+      S.println(F("[ERROR] Invalid hex character.\n"));
+      bad_form();
+      return false;
+    }
+  }
+  return true;
+}
+
+void write_content_to_mem_slot(byte memSlot, int result[], uint8_t arraySize) {
+  
+  byte start[8];                          //All 8 Bytes that store the iButton data
+  if (arraySize == 6 && false) {          //arraySize of 6 is the original one, that the cycle was written for... (ADDED FALSE TO PROHIBIT THIS BLOCK OF CODE FROM RUNNING. EVER.)
+                                          //Also lots of debug prints. Everywhere...
+  SDBGprintln(F("<DEBUG> Is at arraySize 6 "));
+  SDBGprint(F("<DEBUG>(FIRST) Writing to EEPROM at address ")); SDBGprint(0 + (memSlot << 5)); SDBGprint(F(" content: ")); SDBGprintln(0x0C);
+  
+    //EEPROM.write(0 + (memSlot << 5), 0x0C);   //I'm not really sure, why is this needed, like why do we need to write 0x0C as the first byte...
+    //THE PREVIOUS LINE, JUST BRICKED MY iBUTTON WHEN I EDITED THE DATA FROM ANOTHER WORKING ONE,
+    //AND THEN WROTE FROM THE EDITED SLOT TO RW1990. THUS, THIS WILL BE PROHIBITED UNTIL IT'S CLEAR, AS TO WHY IT'S HERE! 
+    start[0] = 0x0C;
+    for(int x = 0; x < 6; x++) {
+    SDBGprint(F("<DEBUG>(FOR) Writing to EEPROM at address ")); SDBGprint(x + (memSlot << 5) + 1); SDBGprint(F(" content: ")); SDBGprintln((byte)result[x]);
+
+      eeprom_write(x + (memSlot << 5) + 1, (byte)result[x]);
+      start[x + 1] = (byte)result[x];
+    }
+
+  SDBGprint(F("<DEBUG>(LAST) Writing to EEPROM at address ")); SDBGprint(7 + (memSlot << 5)); SDBGprint(F(" content: ")); SDBGprintln(crc8(start, 7));
+
+    eeprom_write(7 + (memSlot << 5), crc8(start, 7));
+  } 
+  else if (arraySize == 7) {                  //arraySize of 7 is about a one more, so we autofill only the last Byte - checksum
+
+  SDBGprintln(F("<DEBUG> Is at arraySize 7 "));
+  SDBGprint(F("<DEBUG>(FIRST) Writing to EEPROM at address ")); SDBGprint(0 + (memSlot << 5)); SDBGprint(F(" content: ")); SDBGprintln((byte)result[0]);
+
+    eeprom_write(0 + (memSlot << 5), (byte)result[0]);          //Writing to 0-th Byte in EEPROM
+    start[0] = (byte)result[0];
+
+    for(int x = 1; x < 7; x++) {
+
+    SDBGprint(F("<DEBUG>(FOR) Writing to EEPROM at address ")); SDBGprint(x + (memSlot << 5)); SDBGprint(F(" content: ")); SDBGprintln((byte)result[x]);
+
+      eeprom_write(x + (memSlot << 5), (byte)result[x]);        //Writing 1 to 7-th byte in EEPROM
+      start[x] = (byte)result[x];
+    }
+
+  SDBGprint(F("<DEBUG>(LAST) Writing to EEPROM at address ")); SDBGprint(7 + (memSlot << 5)); SDBGprint(F(" content: ")); SDBGprintln(crc8(start, 7));
+
+    eeprom_write(7 + (memSlot << 5), crc8(start, 7));   //Writing to 8-th Byte in EEPROM
+  } 
+  else if (arraySize == 8) {                  //arraySize of 8 is all of the data, so... yeah, we just do that...
+    for(int x = 0; x < 8; x++) {
+
+    SDBGprint(F("<DEBUG>(FOR) Writing to EEPROM at address ")); SDBGprint(x + (memSlot << 5)); SDBGprint(F(" content: ")); SDBGprintln((byte)result[x]);
+
+      start[x] = (byte)result[x];
+      eeprom_write(x + (memSlot << 5), (byte)result[x]);
+    }
+  }
+
+  #if PINT_DEBUG_SERIAL == true
+  SDBGprint(F("<DEBUG> size of the array \"start\" is: "));
+  byte serialtmp = sizeof(start) / sizeof(start[0]); SDBGprintln(serialtmp);
+  #endif
+
+  SDBGprint(F("<DEBUG> Contents of the array \"start\" are as follows: "));
+  for (size_t i = 0; i < sizeof(start) / sizeof(start[0]); i++)
+  {
+    SDBGprint(start[i]); SDBGprint(F(", "));
+  }
+  SDBGprintln();
+  slot_changed();
+}
+
+void edit_slot(byte memSlot, byte numberOfBytes) {  //Submenu for editing currently active slot's data and name
+  STACK_PROBE("edit_slot");
+  update_slot();
+
+  S.print(F("[INPUT] Waiting for code to program slot: "));
+  S.println(memSlot, HEX);
+  S.print(F("In the following format: "));
+
+  int arraySize = 7;
+  if (advancedMode) arraySize = numberOfBytes;
+  
+  SDBGprint(F("<DEBUG> advanced mode? ")); SDBGprintln(advancedMode);   //TODO: press "return / enter" to just rename the slot.
+  SDBGprint(F("<DEBUG> arraySize: ")); SDBGprintln(arraySize);
+  if (advancedMode && arraySize == 8) {                                 //TODO: modify this, so it's possible to edit range from just 1 (first) to all 8 (all of them)
+    S.println(F("0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08 (ALL 8 Bytes)"));
+  } else if (arraySize == 7) {
+    S.println(F("0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07 (7 Bytes - 8-th one is an autofilled checksum)"));
+  } else {
+    S.println(F("0x01, 0x02, 0x03, 0x04, 0x05, 0x06 (6 Bytes)"));
+  }
+
+  S.println(F("Or just press <return> to keep the code in the memory slot unchanged. (Any invalid input will cause this also)"));
+
+  wait_for_serial_input();                       //Drains the console output meanwhile, the prompt above is longer than the queue
+  Console.settle(50);
+  
+  while(Console.available() > 0) {               //We start reading input from the serial here...
+
+    int result[arraySize];
+
+    if (serial_parse_hex(result, arraySize)) {  //returns true if all of the serial input was successfully parsed, otherwise returns false.
+
+    SDBGprint(F("<DEBUG> size of the array \"result\" is: "));
+    byte serialtmp = sizeof(result) / sizeof(result[0]); SDBGprintln(serialtmp);
+
+    SDBGprint(F("<DEBUG> Contents of the array \"result\" are as follows: "));
+    for (size_t i = 0; i < sizeof(result) / sizeof(result[0]); i++)
+    { SDBGprint(result[i]); SDBGprint(F(", ")); }
+    SDBGprintln();
+    
+    write_content_to_mem_slot(memSlot, result, arraySize);
+
+    S.print(F("[SUCCESS] Code saved to slot "));
+    S.print(memSlot, HEX);
+    S.print("!\n");
+    } else {    //if the serial_parse_hex returned false (something has gone wrong)
+      //return;   //exit this function immediately.
+    } //FIXME due to change/deprecation of the reset func, this no longer leads to renaming slot without editing the contents of it. See the commit desc.
+      //FIXME seems it's... working correctly as of 13.02.2022... the name change doesn't mess with the memory slot content...
+
+    S.println(F("[INPUT] Waiting for name (up to 8 characters)..."));
+    wait_for_serial_input();
+    Console.settle(100);                      //let serial catch up
+    for(int x = 0; x < 8; x++) {
+      if(Console.available() < 1) {
+        eeprom_write(x + 8 + (memSlot << 5), 0x00);
+      } else {
+        byte c = Console.read();
+        if ((c == 13) || (c == 10)) c = 0x00; //if c is Line-Feed or Carriage-Return, convert it to 0x00
+        eeprom_write(x + 8 + (memSlot << 5), c);
+      }
+    }
+    S.println(F("[SUCCESS] Name saved!\n"));
+    clear_serial();                           //Need to remove this for batch command run?
+  }
+}
+
+void print_mem(int lower, int upper, byte memSlot) {
+  if(slot_is_full(memSlot)) {
+    for (byte x = lower; x < upper; x++) {  
+      byte curr_val = EEPROM.read(x + (memSlot << 5));
+      S.print("0x");
+      if (curr_val<0x10) {S.print("0");}
+      S.print(curr_val,HEX);
+      if (x < upper - 1) S.print(", ");
+    }
+  }
+  else {
+    S.print("<EMPTY SLOT>");
+  }
+}
+
+void print_mem_name(byte memSlot) { //TODO: Check if a memSlot is valid (0-F / 0-15) (time to make a is_slot_valid function?)
+  if(EEPROM.read(0 + 8 + (memSlot << 5)) == 0x00) {
+    S.print("<NONAME>");                          //Changed from "<UNNAMED>" to "<NONAME>" for exactly 8 characters
+  }
+  else {
+    for(int x = 0; x < 8; x++) {
+      byte value = EEPROM.read(x + 8 + (memSlot << 5));
+      if(value == 0x00) { //If the saved value is 0...
+        value = 0x20;     //We print a ' ' (space) character. For padding...
+      }
+      S.print((char)value);
+    }
+  }
+}
+
+void print_hex_bytes(const byte data[], byte len) { //Prints Bytes in the same "0x01, 0x02, ..." format the console accepts
+  for (byte x = 0; x < len; x++) {
+    S.print("0x");
+    if (data[x]<0x10) {S.print("0");}
+    S.print(data[x],HEX);
+    if (x < len - 1) S.print(", ");
+  }
+}
+
+void dump_all_mem_slots_to_serial() { //Writes all the slots to the serial, marks the currently active one.
+  for(byte memSlot = 0x00; memSlot < 0x10; memSlot++) {
+    S.print(memSlot, HEX);              //Print number of slot in HEX
+    S.print(" : ");
+    print_mem_name(memSlot);
+    S.print(" : ");
+    if (advancedMode)
+    {
+      print_mem(0, 8, memSlot);         //In Advanced mode
+    } else {
+      print_mem(0, 7, memSlot);         //not in Advanced mode
+    }
+    if (memSlot == activeMemSlot) S.print(F("  <<ACTIVE>>  "));
+    S.println();
+    }
+}
+
+#if USE_OVERDRIVE == true && defined(__AVR__)
+/* Overdrive speed (~10x) bit routines. The OneWire library only does standard speed,
+ * and overdrive time slots are far too short for digitalWrite(), so the pin registers are used directly.
+ * Timing is for 16 MHz, on 8 MHz boards overdrive is marginal and will mostly fall back to standard speed.
+ */
+volatile uint8_t *odIn, *odMode, *odOut;
+uint8_t odMask;
+
+void od_init() {
+  odIn = portInputRegister(digitalPinToPort(IBUTTON));
+  odMode = portModeRegister(digitalPinToPort(IBUTTON));
+  odOut = portOutputRegister(digitalPinToPort(IBUTTON));
+  odMask = digitalPinToBitMask(IBUTTON);
+}
+
+bool od_reset() {     //Overdrive reset, TRUE if anything answered with a presence pulse
+  noInterrupts();
+  *odOut &= ~odMask;  //No pull-up, driven low when it's an output
+  *odMode |= odMask;
+  delayMicroseconds(70);
+  *odMode &= ~odMask;
+  delayMicroseconds(8);
+  bool present = !(*odIn & odMask);
+  interrupts();
+  delayMicroseconds(40);
+  return present;
+}
+
+void od_write_bit(bool bit) {
+  noInterrupts();
+  *odOut &= ~odMask;
+  *odMode |= odMask;
+  if (bit) {
+    delayMicroseconds(1);
+    *odMode &= ~odMask;
+    delayMicroseconds(8);
+  } else {
+    delayMicroseconds(8);
+    *odMode &= ~odMask;
+    delayMicroseconds(2);
+  }
+  interrupts();
+}
+
+bool od_read_bit() {
+  noInterrupts();
+  *odOut &= ~odMask;
+  *odMode |= odMask;
+  delayMicroseconds(1);
+  *odMode &= ~odMask;
+  delayMicroseconds(1);
+  bool bit = *odIn & odMask;
+  interrupts();
+  delayMicroseconds(8);
+  return bit;
+}
+
+void od_write_byte(byte data) {
+  for (byte data_bit = 0; data_bit < 8; data_bit++) {
+    od_write_bit(data & 1);
+    data = data >> 1;
+  }
+}
+
+byte od_read_byte() {
+  byte data = 0;
+  for (byte data_bit = 0; data_bit < 8; data_bit++) {
+    if (od_read_bit()) data |= 1 << data_bit;
+  }
+  return data;
+}
+
+bool od_read_rom(byte dest[8]) {  //Read ROM at overdrive speed, FALSE if nothing answered at that speed
+  if (!ibutton.reset()) return false;
+  ibutton.write(0x3C);            //Overdrive Skip ROM, capable devices switch to overdrive speed
+  bool answered = od_reset();
+  if (answered) {
+    od_write_byte(0x33);          //Read ROM
+    for (byte x = 0; x < 8; x++) {
+      dest[x] = od_read_byte();
+    }
+  }
+  ibutton.reset();                //Standard speed reset brings everything back to standard speed
+  return answered && dest[0] != 0x00 && crc8(dest, 7) == dest[7];
+}
+#endif
+
+#define SAMPLE_OK 0         //sample_iButton() results
+#define SAMPLE_BAD 1        //Something answered, but the ROM didn't pass the CRC (flaky contact)
+#define SAMPLE_NONE 2       //No presence pulse, nothing on the contacts
+
+byte sample_iButton(byte dest[8]) { //One ROM sample, trying overdrive speed first if enabled.
+  bool found;
+#if USE_OVERDRIVE == true && defined(__AVR__)
+  if (overdriveReads && od_read_rom(dest)) {
+    readAtOverdrive = true;
+    return SAMPLE_OK;               //Already CRC checked
+  }
+#endif
+  readAtOverdrive = false;
+  found = ibutton.search(dest);
+  ibutton.reset_search();           //If we don't reset, the next ibutton.search will fail.
+  if (found && dest[0] != 0x00 && crc8(dest, 7) == dest[7]) return SAMPLE_OK; //All zeros has a valid CRC too, that's a shorted bus.
+  return ibutton.reset() ? SAMPLE_BAD : SAMPLE_NONE;
+}
+
+bool search_iButton(byte dest[8], byte slot = STATS_NO_SLOT) { //Validated read: CRC checked samples, done when two consecutive ones agree,
+                                                                //or by majority vote. The retries are counted for the slot.
+  STACK_PROBE("search_iButton");
+  ConsoleHold hold;
+  byte candidate[READ_SAMPLES][8];  //Distinct valid samples...
+  byte votes[READ_SAMPLES];         //...and how many times each one was seen
+  byte candidates = 0, valid = 0;
+  int8_t last = -1;                 //Candidate of the previous sample, -1 if it wasn't valid
+
+  for (readSamples = 1; readSamples <= READ_SAMPLES; readSamples++) {
+    byte sample[8];
+    byte result = sample_iButton(sample);
+    if (result != SAMPLE_OK) {
+      if (readSamples == 1 && result == SAMPLE_NONE) return false;  //Nothing there at all, don't keep the caller waiting
+      last = -1;                    //A bad sample, the other ones still get voted
+      continue;
+    }
+    valid++;
+
+    int8_t c;
+    for (c = 0; c < candidates && memcmp(candidate[c], sample, 8) != 0; c++);
+    if (c == last) {                //Two consecutive samples agree, good enough
+      memcpy(dest, sample, 8);
+      stats_count(STATS_RETRIES, slot, dest[0], readSamples - 2);
+      return true;
+    }
+    if (c == candidates) {
+      memcpy(candidate[c], sample, 8);
+      votes[c] = 0;
+      candidates++;
+    }
+    votes[c]++;
+    last = c;
+  }
+  readSamples = READ_SAMPLES;
+
+  int8_t best = -1;
+  for (int8_t c = 0; c < candidates; c++) {
+    if (best < 0 || votes[c] > votes[best]) best = c;
+  }
+  if (best < 0 || votes[best] < 2 || votes[best] * 2 <= valid) {  //No clear majority, the contact is too flaky
+    stats_count(STATS_RETRIES, slot, 0x00, READ_SAMPLES - 2);     //No family code to count them for
+    return false;
+  }
+  memcpy(dest, candidate[best], 8);
+  stats_count(STATS_RETRIES, slot, dest[0], READ_SAMPLES - 2);
+  return true;
+}
+
+void print_read_speed() {
+  if (readAtOverdrive) {
+    S.println(F("[INFO] Read at OVERDRIVE speed."));
+  } else {
+    S.println(F("[INFO] Read at STANDARD speed."));
+  }
+}
+
+bool detect_iButton() { //Returns TRUE if the iButton was detected, FALSE if any error ocurred
+
+  if (!search_iButton(addr)) {           //read attached ibutton and assign value to buffer "addr"
+    digitalWrite(RED, HIGH);
+    ibutton.reset_search();
+    delay(1);
+    digitalWrite(RED, LOW);
+    return false;                       //Returns FALSE if no iButton could be detected for any reason
+  }
+  ibutton.reset_search();               //If we don't reset, the next ibutton.search will fail.
+  print_read_speed();
+
+  S.print(F("An address / ID of the currently connected iButton is: "));
+  for (byte x = 0; x < 8; x++) {        //Print current ID to the serial...
+    byte curr_val = addr[x];
+    S.print("0x");
+    if (curr_val<0x10) {S.print("0");}
+    S.print(curr_val,HEX);
+    if (x < 8 - 1) S.print(", ");
+  }
+
+  blinkPin(GREEN, 5,150);              //Signal operation success via green LED
+  while(!digitalRead(READ)) delay(1);
+
+  S.println();
+  return true;                          //Returns TRUE after successful execution
+}
+
+bool read_iButton() { //Returns TRUE if the read was successful, FALSE if any error ocurred
+  update_slot();
+  if (!search_iButton(addr, activeMemSlot)){  //read attached ibutton and assign value to buffer "addr"
+    digitalWrite(RED, HIGH);
+    ibutton.reset_search();
+    delay(1);
+    digitalWrite(RED, LOW);
+    return false;                       //Returns FALSE if no iButton could be detected for any reason
+  }
+  ibutton.reset_search();               //If we don't reset, the next ibutton.search will fail.
+  print_read_speed();
+
+  for(int i = 0; i < 8; i++) {
+    eeprom_write(i + (activeMemSlot << 5), addr[i]);
+    code[i] = addr[i];                  //Keeps the pinned snapshot in sync with the EEPROM, no slot_changed() needed
+  }
+  stats_count(STATS_READS, activeMemSlot, addr[0]);
+  journal_append(JOURNAL_READ, activeMemSlot, true, addr);
+
+  blinkPin(GREEN, 5, 150);              //Signal operation success via green LED
+  while(!digitalRead(READ)) delay(1);
+  return true;                          //Returns TRUE after successful execution
+}
+
+void load_blank_driver(byte index, BlankDriver &driver) {
+  memcpy_P(&driver, &BLANK_DRIVERS[index], sizeof(BlankDriver));
+}
+
+void print_blank_driver(byte index) {
+  BlankDriver driver;
+  load_blank_driver(index, driver);
+  S.print((const __FlashStringHelper *)driver.name);
+}
+
+byte probe_blank_driver(OneWireBus &bus) { //Finds the first driver the blank on the bus answers to
+  for (byte x = 0; x < BLANK_DRIVER_COUNT; x++) {
+    BlankDriver driver;
+    load_blank_driver(x, driver);
+    if (driver.flagRead == 0x00) continue;
+
+    if (driver.encoding == BLANK_BYTE_PROGRAM) {  //TM2004 has a status register, nothing else answers to its read
+      if (!bus.reset()) break;
+      bus.skip();                                 //Read Status is a memory function command, it needs a ROM command first
+      byte command[3] = {driver.flagRead, 0x00, 0x00};  //Read Status, address 0x0000
+      for (byte i = 0; i < sizeof(command); i++) bus.write(command[i]);
+      if (bus.read() == crc8(command, sizeof(command))) return x;  //The part answers with the CRC of the command & address
+    } else {                                      //RW1990 variants read back a record flag that was just set
+      if (!bus.reset()) break;
+      bus.write(driver.flagWrite);
+      bus.write_bit(1);
+      delay(10);
+      bus.reset();
+      bus.write(driver.flagRead);
+      if (bus.read() == 0xFE) return x;
+    }
+  }
+  return BLANK_DRIVER_LEGACY;
+}
+
+byte select_blank_driver(OneWireBus &bus) {
+  if (forcedBlankDriver >= 0) return forcedBlankDriver;
+  return probe_blank_driver(bus);
+}
+
+void blank_preamble(OneWireBus &bus, const BlankDriver &driver) {  //Gets a BIT_PULSES blank ready for the data pulses
+  if (driver.flagWrite == 0x00) {
+    bus.skip();                 // This is code preparing RW1990 to be written to...
+    bus.reset();                // THESE LINES ARE VITAL
+    bus.write(0x33);            // I thought they were just for reading, but without these lines,
+    bus.skip();                 // writing will brick the fob forever! I broke 6 writing this program.
+    bus.reset();
+  } else {
+    bus.reset();
+    bus.write(driver.flagWrite);
+    bus.write_bit(driver.unlockBit);
+    delay(10);
+    bus.reset();
+  }
+  bus.write(driver.writeRom);
+}
+
+void blank_finish(OneWireBus &bus, const BlankDriver &driver) {
+  if (driver.relock) {
+    bus.reset();
+    bus.write(driver.flagWrite);
+    bus.write_bit(!driver.unlockBit);
+    delay(10);
+  }
+}
+
+bool write_with_driver(OneWireBus &bus, byte pin, byte index, const byte data[8]) { //Returns TRUE if the blank is still present (and for TM2004, echoed every byte)
+  BlankDriver driver;
+  load_blank_driver(index, driver);
+  bool ok = true;
+
+  if (driver.encoding == BLANK_BYTE_PROGRAM) {
+    bus.reset();
+    bus.write(driver.writeRom);                 //Write ROM is answered without a ROM command first
+    bus.write(0x00);                            //Start address
+    bus.write(0x00);
+    for (byte x = 0; x < 8 && ok; x++) {
+      digitalWrite(RED, HIGH);
+      bus.write(data[x]);
+      bus.read();                               //CRC of the byte, the echo below tells more
+      delayMicroseconds(driver.pulseUs * 10);   //Bus idle, then a '1' slot is the programming pulse...
+      bus.write_bit(1);
+      delay(driver.recoveryMs);                 //...and the byte takes this long to program
+      ok = bus.read() == data[x];
+      digitalWrite(RED, LOW);
+    }
+  } else {
+    blank_preamble(bus, driver);
+    for (byte x = 0; x<8; x++){
+      digitalWrite(RED, HIGH);
+      delay(5);
+      writeByte(pin, data[x], driver);
+      digitalWrite(RED, LOW);
+      delay(15);
+    }
+    blank_finish(bus, driver);
+  }
+
+  ok = bus.reset() && ok;
+  delay(5);
+  bus.reset_search();           //If we don't reset, the next ibutton.search will fail.
+  return ok;
+}
+
+bool write_code_to_iButton(const byte data[8]) { //Programs the given 8 Bytes to the blank on the bus. Returns TRUE if it's still present afterwards.
+  STACK_PROBE("write_code_to_iButton");
+  ConsoleHold hold;
+  byte driver = select_blank_driver(ibutton);
+  S.print(F("[INFO] Blank type: ")); print_blank_driver(driver); S.println();
+  return write_with_driver(ibutton, IBUTTON, driver, data);
+}
+
+bool write_iButton() { //Returns TRUE if the write was successful, FALSE if any error ocurred
+  update_slot();
+  if(!code_is_full()) {
+    blinkPin(RED, 5, 150);
+    while(!digitalRead(WRITE)) delay(1);
+    return false;                 //FALSE, as the slot is empty
+  }
+
+  if (!ibutton.search(addr)) {  //read attached ibutton and assign value to buffer "addr"
+    digitalWrite(RED, HIGH);
+    ibutton.reset_search();
+    delay(1);
+    digitalWrite(RED, LOW);
+    return false;               //Returns FALSE if no iButton could not be detected for any reason
+  }
+  
+  S.print(F("Writing to iButton at address: "));
+  print_hex_bytes(addr, 8);
+  S.println();
+  S.print(F("Writing data: "));
+  print_hex_bytes(code, 8);
+  S.println();
+                  // S.println(F("<DEBUG> NOT PROCEEDING - RETURNING FROM FUNCTION IMMEDIATELY!"));
+                  // return;
+
+  //CRITICAL FIXME THIS MUST BE RUN BEFORE WRITING AS THE WRITE FUNCTION DEPENDS ON IT ENTIRELY!!!
+  //MAKE IT SO THE WRITE ENSURES THE SLOT ISN'T EMPTY, AND SYNCES THIS GLOBAL VARIABLE JUST BEFORE WRITING!
+  //IDEALLY, THE WRITE FUNCTION WOULD GET THE DATA FROM THE CURRENTLY ACTIVE EEPROM SLOT COMPLETELY INDEPENDENTLY!!!
+  //MAKE SURE THE CODE ABOUT TO BE WRITTEN DOES MAKE SENSE AND DOESN'T START WITH ZERO BYTE!!!
+
+  unsigned long started = millis();
+  bool present = write_code_to_iButton(code);
+  stats_write(activeMemSlot, code[0], millis() - started, present);
+  bool verified = present && search_iButton(addr, activeMemSlot) && memcmp(addr, code, 8) == 0;  //Answering doesn't mean the code took
+  ibutton.reset_search();
+  if (!verified) {
+    stats_count(STATS_VERIFY_FAILS, activeMemSlot, code[0]);
+    S.println(F("[ERROR] Verify failed, the blank doesn't read back the written code!"));
+  }
+  journal_append(JOURNAL_WRITE, activeMemSlot, verified, code);
+  blinkPin(verified ? GREEN : RED, 5, 150);
+  while(!digitalRead(WRITE)) delay(1);
+
+  return verified;              //TRUE only if the blank reads back the written code
+}
+
+bool verify_iButton() { //Verify iButton against currently active memory slot
+  update_slot();
+  //Is current memory slot blank?
+  if(!code_is_full()) {S.println(F("[ERROR] Currently active memory slot is blank\n")); return false;}
+  //Is iButton present?
+  //Read iBtn address
+  if (!search_iButton(addr, activeMemSlot)) {  //read attached ibutton and assign value to buffer "addr"
+    digitalWrite(RED, HIGH);
+    ibutton.reset_search();
+    delay(1);
+    digitalWrite(RED, LOW);
+    S.println(F("[ERROR] No iButton device was detected\n"));
+    return false;               //Returns FALSE if no iButton could not be detected for any reason
+  }
+  ibutton.reset_search();               //If we don't reset, the next ibutton.search will fail.
+  print_read_speed();
+
+  //Match against the one in the current memory slot
+  
+  S.print(F("[INFO] Reading code from device slot... "));
+  S.print(activeMemSlot, HEX); S.print(" : ");
+  print_mem_name(activeMemSlot); S.print(" : ");
+  if (advancedMode) {                 //If in advanced mode,
+    print_mem(0, 8, activeMemSlot);     //print all of the 8 bytes...
+  } else {                            //If not in advanced mode however...
+    print_mem(0, 7, activeMemSlot);     //Don't print the last byte (CRC, a calculated cyclical redundancy check)
+    // print_mem(1, 7, activeMemSlot);     //Don't print the first byte (0x0C, family code) and last byte (CRC, a calculated cyclical redundancy check)
+  }
+  S.println();
+
+  detect_iButton();
+
+  S.println();
+
+  bool mismatch = false;
+  for(int i = 0; i < 8; i++) {
+    if (code[i] != addr[i]) {           //The pinned snapshot, the same as the slot's EEPROM
+      mismatch = true;
+      S.print(F("Mismatch on index "));
+      S.print(i);
+      S.print(F(": "));
+      S.print(code[i], HEX);
+      S.print(F("<->"));
+      S.println(addr[i], HEX);
     }
   }
+  S.println();
+  journal_append(JOURNAL_VERIFY, activeMemSlot, !mismatch, addr);
 
-  for(int x = 0; x < arraySize; x++) {
-    result[x] = hexstr_to_int(hexstr[x]);
-    if(result[x] == -1) {
-      S.println(F("[ERROR] Invalid hex character.\n"));
-      bad_form();
-      return false;
-    }
+  if (mismatch) {
+    stats_count(STATS_VERIFY_FAILS, activeMemSlot, code[0]);
+    S.println(F("[ERROR] An iButton address does not correspond to one saved in a memory slot!\n"));
+    return false;
   }
+
+  S.println(F("[SUCCESS] An iButton address matches the one saved in a currently active memory slot!\n"));
   return true;
 }
 
-void write_content_to_mem_slot(byte memSlot, int result[], uint8_t arraySize) {
-  
-  byte start[8];                          //All 8 Bytes that store the iButton data
-  if (arraySize == 6 && false) {          //arraySize of 6 is the original one, that the cycle was written for... (ADDED FALSE TO PROHIBIT THIS BLOCK OF CODE FROM RUNNING. EVER.)
-                                          //Also lots of debug prints. Everywhere...
-  SDBGprintln(F("<DEBUG> Is at arraySize 6 "));
-  SDBGprint(F("<DEBUG>(FIRST) Writing to EEPROM at address ")); SDBGprint(0 + (memSlot << 5)); SDBGprint(F(" content: ")); SDBGprintln(0x0C);
-  
-    //EEPROM.write(0 + (memSlot << 5), 0x0C);   //I'm not really sure, why is this needed, like why do we need to write 0x0C as the first byte...
-    //THE PREVIOUS LINE, JUST BRICKED MY iBUTTON WHEN I EDITED THE DATA FROM ANOTHER WORKING ONE,
-    //AND THEN WROTE FROM THE EDITED SLOT TO RW1990. THUS, THIS WILL BE PROHIBITED UNTIL IT'S CLEAR, AS TO WHY IT'S HERE! 
-    start[0] = 0x0C;
-    for(int x = 0; x < 6; x++) {
-    SDBGprint(F("<DEBUG>(FOR) Writing to EEPROM at address ")); SDBGprint(x + (memSlot << 5) + 1); SDBGprint(F(" content: ")); SDBGprintln((byte)result[x]);
+bool parse_queue_line(const char line[], byte len, byte id[8]) { //Parses 14 (CRC is autofilled) or 16 hex digits into id
+  if (len != 14 && len != 16) return false;
+  for (byte x = 0; x < len / 2; x++) {
+    int high = hex_digit_val_dec(toupper(line[2 * x]));
+    int low = hex_digit_val_dec(toupper(line[2 * x + 1]));
+    if (high == -1 || low == -1) return false;
+    id[x] = high * 16 + low;
+  }
+  if (id[0] == 0x00) return false;            //Zero family code, writing that would only make a useless fob.
+  if (len == 14) {
+    id[7] = crc8(id, 7);
+  } else if (crc8(id, 7) != id[7]) {
+    return false;
+  }
+  return true;
+}
 
-      EEPROM.write(x + (memSlot << 5) + 1, (byte)result[x]);
-      start[x + 1] = (byte)result[x];
+void clone_queue() {  //Writes host-supplied IDs from a RAM queue, one to each presented blank. The IDs never go to the EEPROM, only the statistics & the journal do.
+  STACK_PROBE("clone_queue");
+  byte queue[CLONE_QUEUE_SIZE][8];            //Ring buffer of IDs waiting for a blank
+  byte head = 0, count = 0;
+  byte credit = 0;                            //Lines the host may still send before waiting for the next [CREDIT]
+  unsigned int received = 0, written = 0, failed = 0;
+  char line[CLONE_QUEUE_LINE];
+  byte lineLen = 0;
+  bool lineTooLong = false;
+  bool inputDone = false;
+  bool awaitingRemoval = false;               //The last written blank is still on the contacts, don't write it twice. Local, so every 'Q' run starts clear.
+
+  S.println(F("[INFO] Send one ID per line - 14 hex digits (CRC is autofilled) or all 16 hex digits."));
+  S.println(F("[INFO] Only send as many lines as the last [CREDIT] allows."));
+  S.println(F("[INFO] Send '.' to finish once the queue is written, or 'X' to abort immediately."));
+
+  while (true) {
+    if (!inputDone && credit == 0 && count < CLONE_QUEUE_SIZE) {  //Previous credit used up, grant more.
+      credit = CLONE_QUEUE_SIZE - count;
+      if (credit > CLONE_QUEUE_RX_LINES) credit = CLONE_QUEUE_RX_LINES;
+      S.print(F("[CREDIT] ")); S.println(credit);
     }
 
-  SDBGprint(F("<DEBUG>(LAST) Writing to EEPROM at address ")); SDBGprint(7 + (memSlot << 5)); SDBGprint(F(" content: ")); SDBGprintln(ibutton.crc8(start, 7));
+    while (Console.available() > 0) {          //Collect the incoming lines
+      char c = Console.read();
+      if (c != '\r' && c != '\n') {
+        if (lineLen < CLONE_QUEUE_LINE - 1) {
+          line[lineLen++] = c;
+        } else {
+          lineTooLong = true;
+        }
+        continue;
+      }
+      if (lineLen == 0 && !lineTooLong) continue;   //Empty line, or the second half of CR LF
+
+      if (lineLen == 1 && line[0] == '.') {
+        inputDone = true;
+        S.println(F("[INFO] End of job received, finishing the queued IDs."));
+      } else if (lineLen == 1 && toupper(line[0]) == 'X') {
+        S.print(F("[WARNING] Job aborted! Dropped queued IDs: ")); S.println(count);
+        S.print(F("[DONE] Written: ")); S.print(written); S.print(F(", failed: ")); S.println(failed);
+        return;
+      } else {
+        if (credit > 0) credit--;
+        byte *id = queue[(head + count) % CLONE_QUEUE_SIZE];
+        if (count >= CLONE_QUEUE_SIZE) {
+          S.println(F("[ERROR] Queue is full, line dropped!"));
+        } else if (lineTooLong || !parse_queue_line(line, lineLen, id)) {
+          S.println(F("[ERROR] Invalid ID (14 or 16 hex digits with a valid CRC expected), line dropped!"));
+        } else {
+          count++;
+          received++;
+          S.print(F("[QUEUED] #")); S.println(received);
+        }
+      }
+      lineLen = 0;
+      lineTooLong = false;
+    }
 
-    EEPROM.write(7 + (memSlot << 5), ibutton.crc8(start, 7));
-  } 
-  else if (arraySize == 7) {                  //arraySize of 7 is about a one more, so we autofill only the last Byte - checksum
+    if (count > 0) {
+      byte found[8];
+      bool present = ibutton.search(found);
+      ibutton.reset_search();
+      if (!present) {
+        awaitingRemoval = false;
+      } else if (!awaitingRemoval) {          //A fresh blank, give it the oldest queued ID
+        byte *id = queue[head];
+        unsigned int item = written + failed + 1;
+        unsigned long started = millis();
+        bool present = write_code_to_iButton(id);
+        stats_write(STATS_NO_SLOT, id[0], millis() - started, present);
+        bool verified = ibutton.search(found);
+        ibutton.reset_search();
+        verified = verified && memcmp(found, id, 8) == 0;
+        if (!verified) stats_count(STATS_VERIFY_FAILS, STATS_NO_SLOT, id[0]);
+        journal_append(JOURNAL_QUEUE_WRITE, 0, verified, id);
+
+        S.print(F("[RESULT] #")); S.print(item);
+        if (verified) {
+          written++;
+          S.print(F(" OK "));
+          print_hex_bytes(id, 8);
+          S.println();
+          blinkPin(GREEN, 1, 100);
+        } else {
+          failed++;
+          S.println(F(" ERROR Verify failed, the blank doesn't read back the written ID!"));
+          blinkPin(RED, 1, 100);
+        }
+        head = (head + 1) % CLONE_QUEUE_SIZE;
+        count--;
+        awaitingRemoval = true;
+      }
+    } else if (inputDone) {
+      break;
+    } else if (awaitingRemoval) {             //Queue exhausted, keep watching the contacts, or a blank swapped meanwhile would be taken for the written one
+      byte found[8];
+      awaitingRemoval = ibutton.search(found);
+      ibutton.reset_search();
+    }
 
-  SDBGprintln(F("<DEBUG> Is at arraySize 7 "));
-  SDBGprint(F("<DEBUG>(FIRST) Writing to EEPROM at address ")); SDBGprint(0 + (memSlot << 5)); SDBGprint(F(" content: ")); SDBGprintln((byte)result[0]);
+    if (Console.available() < 1) idle_sleep(true);
+  }
 
-    EEPROM.write(0 + (memSlot << 5), (byte)result[0]);          //Writing to 0-th Byte in EEPROM
-    start[0] = (byte)result[0];
+  S.print(F("[DONE] Written: ")); S.print(written); S.print(F(", failed: ")); S.println(failed);
+}
 
-    for(int x = 1; x < 7; x++) {
+#if USE_MULTI_PROBE == true
+bool probe_detect(byte p, byte found[8]) {  //TRUE if a sane (CRC valid) iButton answers on the probe. Floating contacts can read garbage.
+  bool present = probeBus[p].search(found);
+  probeBus[p].reset_search();
+  return present && found[0] != 0x00 && crc8(found, 7) == found[7];
+}
 
-    SDBGprint(F("<DEBUG>(FOR) Writing to EEPROM at address ")); SDBGprint(x + (memSlot << 5)); SDBGprint(F(" content: ")); SDBGprintln((byte)result[x]);
+void print_probe(byte p) {
+  S.print(F("[PROBE ")); S.print(p); S.print(F("] "));
+}
 
-      EEPROM.write(x + (memSlot << 5), (byte)result[x]);        //Writing 1 to 7-th byte in EEPROM
-      start[x] = (byte)result[x];
+void write_probes_interleaved(const byte data[8]) { //Programs all PROBE_WRITING probes at once, they share the bit recovery
+  STACK_PROBE("write_probes_interleaved");
+  ConsoleHold hold;
+  BlankDriver driver[PROBE_COUNT];
+  byte recoveryMs = 0;
+  for (byte p = 0; p < PROBE_COUNT; p++) {
+    if (probes[p].state != PROBE_WRITING) continue;
+    load_blank_driver(probes[p].driver, driver[p]);
+    if (driver[p].encoding == BLANK_BYTE_PROGRAM) { //Byte programmed blanks pulse & echo byte by byte, nothing to interleave
+      write_with_driver(probeBus[p], probePin[p], probes[p].driver, data);
+      probes[p].state = PROBE_VERIFYING;
+      continue;
     }
+    blank_preamble(probeBus[p], driver[p]);
+    if (driver[p].recoveryMs > recoveryMs) recoveryMs = driver[p].recoveryMs;
+  }
 
-  SDBGprint(F("<DEBUG>(LAST) Writing to EEPROM at address ")); SDBGprint(7 + (memSlot << 5)); SDBGprint(F(" content: ")); SDBGprintln(ibutton.crc8(start, 7));
+  for (byte x = 0; x < 8 && recoveryMs > 0; x++) {
+    digitalWrite(RED, HIGH);
+    delay(5);
+    for (byte p = 0; p < PROBE_COUNT; p++) {
+      if (probes[p].state == PROBE_WRITING) trace_pulses(probePin[p], driver[p].invertBits ? ~data[x] : data[x]);
+    }
+    for (byte data_bit = 0; data_bit < 8; data_bit++) {
+      for (byte p = 0; p < PROBE_COUNT; p++) {  //Pulse slots of all the probes back to back...
+        if (probes[p].state != PROBE_WRITING) continue;
+        byte value = driver[p].invertBits ? ~data[x] : data[x];
+        write_bit_pulse(probePin[p], (value >> data_bit) & 1, driver[p].pulseUs);
+      }
+      delay(recoveryMs);                        //...then a single recovery for all of them.
+    }
+    digitalWrite(RED, LOW);
+    delay(15);
+  }
 
-    EEPROM.write(7 + (memSlot << 5), ibutton.crc8(start, 7));   //Writing to 8-th Byte in EEPROM
-  } 
-  else if (arraySize == 8) {                  //arraySize of 8 is all of the data, so... yeah, we just do that...
-    for(int x = 0; x < 8; x++) {
+  for (byte p = 0; p < PROBE_COUNT; p++) {
+    if (probes[p].state == PROBE_WRITING) {
+      blank_finish(probeBus[p], driver[p]);
+      probeBus[p].reset();
+      probeBus[p].reset_search();
+      probes[p].state = PROBE_VERIFYING;
+    }
+  }
+  delay(5);
+}
 
-    SDBGprint(F("<DEBUG>(FOR) Writing to EEPROM at address ")); SDBGprint(x + (memSlot << 5)); SDBGprint(F(" content: ")); SDBGprintln((byte)result[x]);
+void multi_probe_clone() {  //Clones the active memory slot to the blanks on all the probes, until 'X' is received
+  STACK_PROBE("multi_probe_clone");
+  update_slot();
+  if(!code_is_full()) {S.println(F("[ERROR] Currently active memory slot is blank\n")); return;}
+
+  byte data[8];
+  memcpy(data, code, 8);                        //Keep writing the same code, even if the slot selector moves meanwhile
+  byte slot = activeMemSlot;
+  S.print(F("[INFO] Cloning slot ")); S.print(activeMemSlot, HEX);
+  S.print(F(" to up to ")); S.print((int)PROBE_COUNT); S.println(F(" iButtons at once."));
+  S.println(F("[INFO] Enter 'X' to stop."));
+
+  memset(probes, 0, sizeof(probes));
+  unsigned long lastDetected = 0;
+
+  while (true) {
+    if (Console.available() > 0 && toupper(Console.read()) == 'X') break;
+
+    byte found[8];
+    byte ready = 0;
+    for (byte p = 0; p < PROBE_COUNT; p++) {    //Detection, for every probe on its own
+      bool present = probe_detect(p, found);
+      if (probes[p].state == PROBE_IDLE && present) {
+        probes[p].state = PROBE_PRESENT;
+        probes[p].driver = select_blank_driver(probeBus[p]);
+        probeBus[p].reset_search();
+        lastDetected = millis();
+        print_probe(p); S.print(F("DETECTED ")); print_hex_bytes(found, 8);
+        S.print(F(" : ")); print_blank_driver(probes[p].driver); S.println();
+      } else if (!present && probes[p].state != PROBE_IDLE) {
+        if (probes[p].state == PROBE_PRESENT) {print_probe(p); S.println(F("REMOVED before it was written"));}
+        probes[p].state = PROBE_IDLE;
+      }
+      if (probes[p].state == PROBE_PRESENT) ready++;
+    }
 
-      start[x] = (byte)result[x];
-      EEPROM.write(x + (memSlot << 5), (byte)result[x]);
+    if (ready > 0 && millis() - lastDetected >= PROBE_SETTLE_MS) {
+      for (byte p = 0; p < PROBE_COUNT; p++) {
+        if (probes[p].state == PROBE_PRESENT) probes[p].state = PROBE_WRITING;
+      }
+      unsigned long started = millis();
+      write_probes_interleaved(data);
+      unsigned long took = millis() - started;  //For the whole batch, every blank is counted with its share of it
+
+      for (byte p = 0; p < PROBE_COUNT; p++) {  //Verify & report
+        if (probes[p].state != PROBE_VERIFYING) continue;
+        print_probe(p);
+        bool present = probe_detect(p, found);
+        stats_write(slot, data[0], took / ready, present);
+        bool verified = present && memcmp(found, data, 8) == 0;
+        journal_append(JOURNAL_WRITE, slot, verified, data);
+        if (verified) {
+          probes[p].state = PROBE_DONE;
+          probes[p].written++;
+          S.println(F("OK"));
+        } else {
+          probes[p].state = PROBE_FAILED;
+          probes[p].failed++;
+          stats_count(STATS_VERIFY_FAILS, slot, data[0]);
+          S.println(F("ERROR Verify failed, the blank doesn't read back the written code!"));
+        }
+      }
+      S.print(F("[INFO] Batch of ")); S.print(ready); S.print(F(" written in ")); S.print(took); S.println(F(" ms"));
+      blinkPin(GREEN, 1, 100);
     }
-  }
 
-  #if PINT_DEBUG_SERIAL == true
-  SDBGprint(F("<DEBUG> size of the array \"start\" is: "));
-  byte serialtmp = sizeof(start) / sizeof(start[0]); SDBGprintln(serialtmp);
-  #endif
+    if (Console.available() < 1) idle_sleep(true);
+  }
 
-  SDBGprint(F("<DEBUG> Contents of the array \"start\" are as follows: "));
-  for (size_t i = 0; i < sizeof(start) / sizeof(start[0]); i++)
-  {
-    SDBGprint(start[i]); SDBGprint(F(", "));
+  for (byte p = 0; p < PROBE_COUNT; p++) {
+    print_probe(p);
+    S.print(F("Written: ")); S.print(probes[p].written); S.print(F(", failed: ")); S.println(probes[p].failed);
   }
-  SDBGprintln();
 }
+#endif
 
-void edit_slot(byte memSlot, byte numberOfBytes) {  //Submenu for editing currently active slot's data and name
-  update_slot();
+#if USE_EMULATION == true && defined(__AVR__)
+unsigned int emu_counter(volatile unsigned int &counter) {  //16-bit reads of the ISR counters must not be torn
+  noInterrupts();
+  unsigned int value = counter;
+  interrupts();
+  return value;
+}
 
-  S.print(F("[INPUT] Waiting for code to program slot: "));
-  S.println(memSlot, HEX);
-  S.print(F("In the following format: "));
+void emu_start(const byte rom[8]) { //Arms the slave in the pin change interrupt of the IBUTTON pin
+  memcpy(emuRom, rom, 8);
+  pinMode(IBUTTON, INPUT);                //Released, no internal pull-up. The 4.7k holds the bus up.
+  emuInReg = portInputRegister(digitalPinToPort(IBUTTON));
+  emuModeReg = portModeRegister(digitalPinToPort(IBUTTON));
+  emuMask = digitalPinToBitMask(IBUTTON);
+  emuState = EMU_IDLE;
+  emuResets = emuReads = emuSearches = 0;
+
+  noInterrupts();
+  emuTimerInterrupts = TIMSK0;
+  TIMSK0 &= ~(_BV(TOIE0) | _BV(OCIE0A)); //No millis() or console drain interrupt in the middle of a time slot
+  *digitalPinToPCMSK(IBUTTON) |= _BV(digitalPinToPCMSKbit(IBUTTON));
+  PCIFR = _BV(PCIF0);
+  PCICR |= _BV(PCIE0);
+  emulationActive = true;
+  interrupts();
+}
 
-  int arraySize = 7;
-  if (advancedMode) arraySize = numberOfBytes;
-  
-  SDBGprint(F("<DEBUG> advanced mode? ")); SDBGprintln(advancedMode);   //TODO: press "return / enter" to just rename the slot.
-  SDBGprint(F("<DEBUG> arraySize: ")); SDBGprintln(arraySize);
-  if (advancedMode && arraySize == 8) {                                 //TODO: modify this, so it's possible to edit range from just 1 (first) to all 8 (all of them)
-    S.println(F("0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08 (ALL 8 Bytes)"));
-  } else if (arraySize == 7) {
-    S.println(F("0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07 (7 Bytes - 8-th one is an autofilled checksum)"));
-  } else {
-    S.println(F("0x01, 0x02, 0x03, 0x04, 0x05, 0x06 (6 Bytes)"));
+void emu_stop() {
+  noInterrupts();
+  emulationActive = false;
+  *digitalPinToPCMSK(IBUTTON) &= ~_BV(digitalPinToPCMSKbit(IBUTTON));
+  TIMSK0 = emuTimerInterrupts;
+  interrupts();
+  pinMode(IBUTTON, INPUT);
+}
+
+void emulate_iButton() {  //Acts as a DS1990A with the active memory slot's ID on the IBUTTON pin, until 'X' is received
+  update_slot();
+  if(!code_is_full()) {S.println(F("[ERROR] Currently active memory slot is blank\n")); return;}
+  volatile uint8_t *pcicr = digitalPinToPCICR(IBUTTON);  //Through a variable like in pin_change_wake(), a constant &PCICR == 0 warns
+  if (pcicr == 0 || digitalPinToPCICRbit(IBUTTON) != 0) {
+    S.println(F("[ERROR] Emulation needs the IBUTTON pin to be on the PCINT0 pin change interrupt (port B)!\n"));
+    return;
   }
 
-  S.println(F("Or just press <return> to keep the code in the memory slot unchanged. (Any invalid input will cause this also)"));
+  S.print(F("[INFO] Emulating slot ")); S.print(activeMemSlot, HEX); S.print(F(" : "));
+  print_hex_bytes(code, 8); S.println();
+  S.println(F("[INFO] Answering reset, Read ROM (0x33) & Search ROM (0xF0). Enter 'X' to stop."));
+  S.println(F("[WARNING] millis() is stopped meanwhile, so nothing time based runs."));
+  S.println(F("[INFO] No console output until then, the serial interrupts would stretch the time slots."));
+  Console.flush();                        //Sent completely, no UART interrupt fires while emulating
 
-  while(Serial.available() <= 0);               //TODO: can we use wait_for_serial_input() function here? Should we add "timeout" parameter to it?
-  delay(50);
-  
-  while(Serial.available() > 0) {               //We start reading input from the serial here...
+  {
+    ConsoleHold hold;                     //Anything printed meanwhile (e.g. trace records) waits in the queue
+    emu_start(code);
+    while (!(Console.available() > 0 && toupper(Console.read()) == 'X')); //Nothing to pump while held, the flush() above sent the prompt
+    emu_stop();
+  }
 
-    int result[arraySize];
+  S.print(F("[SUCCESS] Emulation stopped. Resets: ")); S.print(emu_counter(emuResets));
+  S.print(F(", Read ROMs: ")); S.print(emu_counter(emuReads)); S.print(F(", Search ROMs: ")); S.println(emu_counter(emuSearches));
+}
+#endif
 
-    if (serial_parse_hex(result, arraySize)) {  //returns true if all of the serial input was successfully parsed, otherwise returns false.
+unsigned int memory_pages(byte family) { //Number of 32 Byte pages of a memory iButton, 0 if the family isn't known
+  for (byte x = 0; x < sizeof(MEMORY_FAMILIES) / sizeof(MEMORY_FAMILIES[0]); x++) {
+    if (pgm_read_byte(&MEMORY_FAMILIES[x].family) == family) return pgm_read_word(&MEMORY_FAMILIES[x].pages);
+  }
+  return 0;
+}
 
-    SDBGprint(F("<DEBUG> size of the array \"result\" is: "));
-    byte serialtmp = sizeof(result) / sizeof(result[0]); SDBGprintln(serialtmp);
+void dump_iButton_memory() { //Streams the whole NV memory to serial, page by page, with CRC16 per page. Nothing is buffered.
+  STACK_PROBE("dump_iButton_memory");
+  if (!search_iButton(addr)) {
+    ibutton.reset_search();
+    S.println(F("[ERROR] No iButton device was detected\n"));
+    return;
+  }
+  ibutton.reset_search();
+  unsigned int pages = memory_pages(addr[0]);
+  if (pages == 0) {
+    S.print(F("[ERROR] Family code ")); print_hex_bytes(addr, 1); S.println(F(" is not a known memory iButton!\n"));
+    return;
+  }
 
-    SDBGprint(F("<DEBUG> Contents of the array \"result\" are as follows: "));
-    for (size_t i = 0; i < sizeof(result) / sizeof(result[0]); i++)
-    { SDBGprint(result[i]); SDBGprint(F(", ")); }
-    SDBGprintln();
-    
-    write_content_to_mem_slot(memSlot, result, arraySize);
+  S.print(F("[INFO] Memory iButton, pages: ")); S.println(pages);
+  S.println(F("[INPUT] Start page in 0x00 format (to resume a dump), or <return> to start from the first page."));
+  wait_for_serial_input();
+  Console.settle(50);
+  unsigned int start = 0;
+  if (Console.peek() == 10 || Console.peek() == 13) {
+    Console.read();
+  } else {
+    int result[1];
+    if (!serial_parse_hex(result, 1)) return;
+    start = result[0];
+  }
+  if (start >= pages) {
+    S.println(F("[ERROR] Start page is past the end of the memory!\n"));
+    return;
+  }
 
-    S.print(F("[SUCCESS] Code saved to slot "));
-    S.print(memSlot, HEX);
-    S.print("!\n");
-    } else {    //if the serial_parse_hex returned false (something has gone wrong)
-      //return;   //exit this function immediately.
-    } //FIXME due to change/deprecation of the reset func, this no longer leads to renaming slot without editing the contents of it. See the commit desc.
-      //FIXME seems it's... working correctly as of 13.02.2022... the name change doesn't mess with the memory slot content...
+  S.println(F("[INFO] Each line is: page : 32 Bytes : CRC16 (1-Wire CRC16 over the 32 Bytes)"));
+  S.println(F("[INFO] Send XOFF (CTRL+S) / XON (CTRL+Q) to pause / continue, 'X' to stop."));
 
-    S.println(F("[INPUT] Waiting for name (up to 8 characters)..."));
-    while(Serial.available() < 1) delay(1);
-    delay(100);                               //let serial catch up
-    for(int x = 0; x < 8; x++) {
-      if(Serial.available() < 1) {
-        EEPROM.write(x + 8 + (memSlot << 5), 0x00);
-      } else {
-        byte c = Serial.read();
-        if ((c == 13) || (c == 10)) c = 0x00; //if c is Line-Feed or Carriage-Return, convert it to 0x00
-        EEPROM.write(x + 8 + (memSlot << 5), c);
+  ibutton.reset();
+  ibutton.select(addr);
+  ibutton.write(0xF0);                          //Read Memory, from the start page on, till the end
+  ibutton.write((start << 5) & 0xFF);
+  ibutton.write(start >> 3);
+
+  unsigned int page;
+  bool paused = false, stopped = false;
+  for (page = start; page < pages; page++) {
+    while (Console.available() > 0 || paused) {  //The 1-Wire bus doesn't mind waiting between the time slots
+      if (Console.available() < 1) {
+        idle_sleep(false);
+        continue;
+      }
+      char ch = toupper(Console.read());
+      if (ch == 0x13) paused = true;
+      else if (ch == 0x11) paused = false;
+      else if (ch == 'X') {
+        stopped = true;
+        break;
       }
     }
-    S.println(F("[SUCCESS] Name saved!\n"));
-    clear_serial();                           //Need to remove this for batch command run?
-  }
-}
+    if (stopped) break;
 
-void print_mem(int lower, int upper, byte memSlot) {
-  if(slot_is_full(memSlot)) {
-    for (byte x = lower; x < upper; x++) {  
-      byte curr_val = EEPROM.read(x + (memSlot << 5));
-      S.print("0x");
-      if (curr_val<0x10) {S.print("0");}
-      S.print(curr_val,HEX);
-      if (x < upper - 1) S.print(", ");
+    S.print("0x");
+    if (page < 0x10) {S.print("0");}
+    S.print(page, HEX);
+    S.print(" : ");
+    unsigned int crc = 0;
+    for (byte x = 0; x < 32; x++) {
+      byte data = ibutton.read();
+      crc = OneWire::crc16(&data, 1, crc);
+      if (data < 0x10) {S.print("0");}
+      S.print(data, HEX);
     }
+    S.print(F(" : 0x"));
+    for (unsigned int digit = 0x1000; digit > 1 && crc < digit; digit >>= 4) S.print("0");
+    S.println(crc, HEX);
   }
-  else {
-    S.print("<EMPTY SLOT>");
+
+  bool stillPresent = ibutton.reset();
+  if (stopped) {
+    S.print(F("[WARNING] Dump stopped! Resume from page 0x")); S.println(page, HEX);
+  } else if (!stillPresent) {
+    S.println(F("[ERROR] iButton was lost during the dump, the last pages are likely garbage!"));
+  } else {
+    S.println(F("[SUCCESS] Memory dump done!"));
   }
 }
 
-void print_mem_name(byte memSlot) { //TODO: Check if a memSlot is valid (0-F / 0-15) (time to make a is_slot_valid function?)
-  if(EEPROM.read(0 + 8 + (memSlot << 5)) == 0x00) {
-    S.print("<NONAME>");                          //Changed from "<UNNAMED>" to "<NONAME>" for exactly 8 characters
-  }
-  else {
-    for(int x = 0; x < 8; x++) {
-      byte value = EEPROM.read(x + 8 + (memSlot << 5));
-      if(value == 0x00) { //If the saved value is 0...
-        value = 0x20;     //We print a ' ' (space) character. For padding...
-      }
-      S.print((char)value);
-    }
+unsigned int macro_addr(byte macro) {
+  return MACRO_ADDR + macro * MACRO_SIZE;
+}
+
+byte macro_length(byte macro) { //Length of the command text, erased (0xFF) EEPROM is an empty macro
+  byte len = 0;
+  while (len < MACRO_TEXT) {
+    byte c = EEPROM.read(macro_addr(macro) + 8 + len);
+    if (c == 0x00 || c == 0xFF) break;
+    len++;
   }
+  return len;
 }
 
-void dump_all_mem_slots_to_serial() { //Writes all the slots to the serial, marks the currently active one.
-  for(byte memSlot = 0x00; memSlot < 0x10; memSlot++) {
-    S.print(memSlot, HEX);              //Print number of slot in HEX
-    S.print(" : ");
-    print_mem_name(memSlot);
+void print_macros() {
+  for (byte macro = 0; macro < MACRO_COUNT; macro++) {
+    S.print(macro); S.print(" : ");
+    byte len = macro_length(macro);
+    if (len == 0) {
+      S.println(F("<EMPTY>"));
+      continue;
+    }
+    for (byte x = 0; x < 8; x++) {
+      byte c = EEPROM.read(macro_addr(macro) + x);
+      S.print(c == 0x00 ? ' ' : (char)c);
+    }
     S.print(" : ");
-    if (advancedMode)
-    {
-      print_mem(0, 8, memSlot);         //In Advanced mode
-    } else {
-      print_mem(0, 7, memSlot);         //not in Advanced mode
+    for (byte x = 0; x < len; x++) {
+      S.print((char)EEPROM.read(macro_addr(macro) + 8 + x));
     }
-    if (memSlot == activeMemSlot) S.print(F("  <<ACTIVE>>  "));
     S.println();
-    }
+  }
 }
 
-//TODO: Implement CRC checking to make sure that iButton device is present (not just garbage). See ibutton.search() desc.
-
-bool detect_iButton() { //Returns TRUE if the iButton was detected, FALSE if any error ocurred
-
-  if (!ibutton.search(addr)) {           //read attached ibutton and assign value to buffer "addr"
-    digitalWrite(RED, HIGH);
-    ibutton.reset_search();
-    delay(1);
-    digitalWrite(RED, LOW);
-    return false;                       //Returns FALSE if no iButton could be detected for any reason
+byte read_console_line(char buf[], byte size) {  //Reads a line up to the <return>, empty lines are skipped. 0xFF if it doesn't fit to buf.
+  byte len = 0;
+  bool tooLong = false;
+  while (true) {
+    wait_for_serial_input();
+    char c = Console.read();
+    if (c == '\r' || c == '\n') {
+      if (len == 0 && !tooLong) continue;
+      break;
+    }
+    if (len < size) {
+      buf[len++] = c;
+    } else {
+      tooLong = true;
+    }
   }
-  ibutton.reset_search();               //If we don't reset, the next ibutton.search will fail.
+  return tooLong ? 0xFF : len;
+}
 
-  S.print(F("An address / ID of the currently connected iButton is: "));
-  for (byte x = 0; x < 8; x++) {        //Print current ID to the serial...
-    byte curr_val = addr[x];
-    S.print("0x");
-    if (curr_val<0x10) {S.print("0");}
-    S.print(curr_val,HEX);
-    if (x < 8 - 1) S.print(", ");
+void record_macro(byte macro) {
+  STACK_PROBE("record_macro");
+  char name[8];
+  char text[MACRO_TEXT];
+  S.println(F("[INPUT] Macro name (up to 8 characters), then <return>:"));
+  byte nameLen = read_console_line(name, sizeof(name));
+  if (nameLen == 0xFF) {S.println(F("[ERROR] Name is too long! Macro unchanged.")); return;}
+  S.print(F("[INPUT] Commands exactly as they would be typed (up to ")); S.print(MACRO_TEXT); S.println(F(" characters), then <return>:"));
+  byte textLen = read_console_line(text, sizeof(text));
+  if (textLen == 0xFF) {S.println(F("[ERROR] Commands are too long! Macro unchanged.")); return;}
+
+  for (byte x = 0; x < 8; x++) {
+    eeprom_update(macro_addr(macro) + x, x < nameLen ? name[x] : 0x00);
   }
+  for (byte x = 0; x < textLen; x++) {
+    eeprom_update(macro_addr(macro) + 8 + x, text[x]);
+  }
+  if (textLen < MACRO_TEXT) eeprom_update(macro_addr(macro) + 8 + textLen, 0x00);
+  S.println(F("[SUCCESS] Macro saved!"));
+}
 
-  blinkPin(GREEN, 5,150);              //Signal operation success via green LED
-  while(!digitalRead(READ)) delay(1);
+void macro_menu() { //Lists the macros & runs / records / clears the selected one
+  STACK_PROBE("macro_menu");
+  print_macros();
+  S.println(F("[INFO] Write 0-3 to run a macro, 'R' and 0-3 to record one, 'C' and 0-3 to clear one, or 'X' to cancel."));
+  wait_for_serial_input();
+  char ch = toupper(Console.read());
+  if (ch == 'X') return;
+  char action = 0;
+  if (ch == 'R' || ch == 'C') {
+    action = ch;
+    wait_for_serial_input();
+    ch = Console.read();
+  }
+  if (ch < '0' || ch >= '0' + MACRO_COUNT) {
+    S.println(F("[ERROR] Invalid input! No macro selected."));
+    clear_serial();
+    return;
+  }
+  byte macro = ch - '0';
+
+  if (action == 'R') {
+    record_macro(macro);
+  } else if (action == 'C') {
+    eeprom_update(macro_addr(macro) + 8, 0x00);
+    S.println(F("[SUCCESS] Macro cleared!"));
+  } else if (macro_length(macro) == 0) {
+    S.println(F("[ERROR] This macro is empty!"));
+  } else {
+    S.print(F("[INFO] Running macro ")); S.println(macro);
+    Console.run(macro_addr(macro) + 8, macro_addr(macro) + 8 + macro_length(macro));
+  }
+}
 
+void list_command() { //list iBtn
+  S.println(F("===LIST / detect / read connected iButton==="));
+  if (detect_iButton()) {
+    S.println(F("[SUCCESS]"));
+  } else {
+    S.println(F("[ERROR] An error has occurred during an attemt to read the iButton!"));
+    S.println(F("[INFO] Check your electrical connections!"));
+  }
   S.println();
-  return true;                          //Returns TRUE after successful execution
 }
 
-bool read_iButton() { //Returns TRUE if the read was successful, FALSE if any error ocurred
+void show_command() { //Show
+  S.println(F("===SHOW contents of the currently active memory slot==="));
   update_slot();
-  if (!ibutton.search(addr)){           //read attached ibutton and assign value to buffer "addr"
-    digitalWrite(RED, HIGH);
-    ibutton.reset_search();
-    delay(1);
-    digitalWrite(RED, LOW);
-    return false;                       //Returns FALSE if no iButton could be detected for any reason
+  if(code_is_full()) {
+    S.print(F("[INFO] Reading code from device slot... "));
+    S.print(activeMemSlot, HEX); S.print(" : ");
+    print_mem_name(activeMemSlot); S.print(" : ");
+    if (advancedMode) {                 //If in advanced mode,
+    print_mem(0, 8, activeMemSlot);     //print all of the 8 bytes...
+    } else {                            //If not in advanced mode however...
+    print_mem(0, 7, activeMemSlot);     //Don't print the last byte (CRC, a calculated cyclical redundancy check)
+    // print_mem(1, 7, activeMemSlot);     //Don't print the first byte (0x0C, family code) and last byte (CRC, a calculated cyclical redundancy check)
+    }
+    S.println("\n");
   }
-  ibutton.reset_search();               //If we don't reset, the next ibutton.search will fail.
+  else {
+    S.print("[ERROR] No code stored in slot ");
+    S.print(activeMemSlot, HEX);
+    S.println(" yet.\n");
+  }
+}
 
-  for(int i = 0; i < 8; i++) {
-    EEPROM.write(i + (activeMemSlot << 5), addr[i]);
-    code[i] = addr[i];
+void read_command() { //read iBtn
+  S.println(F("===READ FROM iButton to currently active memory slot==="));
+  S.println(F("[INFO] Reading from the iButton & saving to currently selected slot!"));
+
+  if (read_iButton()) {
+    S.println(F("[SUCCESS] Read was successful!"));
+  } else {
+    S.println(F("[ERROR] An error has occurred during an attemt to read the iButton!"));
+    S.println(F("[INFO] Check your electrical connections!"));
   }
 
-  blinkPin(GREEN, 5, 150);              //Signal operation success via green LED
-  while(!digitalRead(READ)) delay(1);
-  return true;                          //Returns TRUE after successful execution
+  S.println();
 }
 
-bool write_iButton() { //Returns TRUE if the write was successful, FALSE if any error ocurred
-  update_slot();
-  if(!slot_is_full(activeMemSlot)) {
-    blinkPin(RED, 5, 150);
-    while(!digitalRead(WRITE)) delay(1);
-    return false;                 //FALSE, as the slot is empty
-  }
+void write_command() { //write iBtn
+  S.println(F("===WRITE TO iButton from currently active memory slot==="));
+  S.println(F("[INFO] Reading from the currently selected slot & writing to the iButton!"));
 
-  if (!ibutton.search(addr)) {  //read attached ibutton and assign value to buffer "addr"
-    digitalWrite(RED, HIGH);
-    ibutton.reset_search();
-    delay(1);
-    digitalWrite(RED, LOW);
-    return false;               //Returns FALSE if no iButton could not be detected for any reason
-  }
-  
-  S.print(F("Writing to iButton at address: "));
-  for (byte x = 0; x < 8; x++) {  
-    byte curr_val = addr[x];
-    S.print("0x");
-    if (curr_val<0x10) {S.print("0");}
-    S.print(curr_val,HEX);
-    if (x < 8 - 1) S.print(", ");
+  if (write_iButton()) {
+    S.print(F("[SUCCESS] Data from the current memory slot ")); S.print(activeMemSlot); S.println(F(" was written to the iButton and reads back."));
+  } else {
+    S.println(F("[ERROR] An error has occurred during an attemt to write to the iButton!"));
+    S.println(F("[INFO] It might be that your currently selected slot is EMPTY, or the blank doesn't read back the written code!"));
+    S.println(F("[INFO] Check if reading does work. If not, "));
+    S.println(F("[INFO] check your electrical connections!"));
   }
+
   S.println();
-  S.print(F("Writing data: "));
+}
 
-  for (byte x = 0; x<8; x++){
-    byte curr_val = code[x];
-    S.print("0x");
-    if (curr_val<0x10) {S.print("0");}
-    S.print(curr_val,HEX);
-    if (x < 8 - 1) S.print(", ");
-    }
-    S.println();
-                  // S.println(F("<DEBUG> NOT PROCEEDING - RETURNING FROM FUNCTION IMMEDIATELY!"));
-                  // return;
+void verify_command() { //Verify
+  verify_iButton();
+}
 
-  //CRITICAL FIXME THIS MUST BE RUN BEFORE WRITING AS THE WRITE FUNCTION DEPENDS ON IT ENTIRELY!!!
-  //MAKE IT SO THE WRITE ENSURES THE SLOT ISN'T EMPTY, AND SYNCES THIS GLOBAL VARIABLE JUST BEFORE WRITING!
-  //IDEALLY, THE WRITE FUNCTION WOULD GET THE DATA FROM THE CURRENTLY ACTIVE EEPROM SLOT COMPLETELY INDEPENDENTLY!!!
-  //MAKE SURE THE CODE ABOUT TO BE WRITTEN DOES MAKE SENSE AND DOESN'T START WITH ZERO BYTE!!!
+void edit_command() { //Edit
+  S.println(F("===Manually EDITING the currently active memory slot==="));
+  if (advancedMode) {
+    edit_slot(activeMemSlot, 8);
+  } else {
+    edit_slot(activeMemSlot, 7);
+  }
+}
 
-  ibutton.skip();               // This is code preparing RW1990 to be written to...
-  ibutton.reset();              // THESE LINES ARE VITAL
-  ibutton.write(0x33);          // I thought they were just for reading, but without these lines,
-  ibutton.skip();               // writing will brick the fob forever! I broke 6 writing this program.
-  ibutton.reset();
-  ibutton.write(0xD5);
-  
-  for (byte x = 0; x<8; x++){
-    digitalWrite(RED, HIGH);
-    delay(5);
-    writeByte(code[x]);
-    digitalWrite(RED, LOW);
-    delay(15);
+void clear_command() { //Clear
+  S.println(F("===CLEAR the currently active memory slot==="));
+  update_slot();
+  S.print(F("[INFO] Clearing slot "));
+  S.print(activeMemSlot, HEX);
+  S.println("...");
+
+  for(int x = 0; x < 16; x++) {
+    eeprom_write(x + (activeMemSlot << 5), 0x00);
   }
-                                //TODO: Implement readback to make sure everything was written correctly...?
-  ibutton.reset();
-  delay(5);
-  ibutton.reset_search();       //If we don't reset, the next ibutton.search will fail.
-  blinkPin(GREEN, 5, 150);
-  while(!digitalRead(WRITE)) delay(1);
+  slot_changed();
 
-  return true;                  //TRUE, as the writing should be successfully done at this point.
+  S.print(F("[SUCCESS] Slot "));
+  S.print(activeMemSlot, HEX);
+  S.println(F(" cleared!\n"));
 }
 
-bool verify_iButton() { //Verify iButton against currently active memory slot
-  update_slot();
-  //Is current memory slot blank?
-  if(!slot_is_full(activeMemSlot)) {S.println(F("[ERROR] Currently active memory slot is blank\n")); return false;}
-  //Is iButton present?
-  //Read iBtn address
-  if (!ibutton.search(addr)) {  //read attached ibutton and assign value to buffer "addr"
-    digitalWrite(RED, HIGH);
+void dump_command() { //Dump
+  S.println(F("===DUMP all memory slots==="));
+  S.println(F("[INFO] Dumping all slots..."));
+  S.println();
+  dump_all_mem_slots_to_serial();
+  S.println();
+  print_stats();
+  S.println();
+  S.println(F("[SUCCESS] Done dumping all slots!"));
+  S.println();
+}
+
+void memory_dump_command() { //Memory iButton dump
+  S.println(F("===GET / dump the whole memory of connected memory iButton==="));
+  dump_iButton_memory();
+  S.println();
+}
+
+void wait_command() { //wait iBtn
+  S.println(F("===Waiting for iButton device==="));
+  S.println(F("[WARNING] Code execution is being blocked until iButton device is detected!"));
+  S.println(F("[INFO] You can now queue commands and inputs for those commands."));
+  S.println(F("[INFO] On bad input, however, rest of the queued commands will be invalidated!"));
+  byte throwaway[8];
+  while(!ibutton.search(throwaway)) {
     ibutton.reset_search();
-    delay(1);
-    digitalWrite(RED, LOW);
-    S.println(F("[ERROR] No iButton device was detected\n"));
-    return false;               //Returns FALSE if no iButton could not be detected for any reason
+    idle_sleep(true);         //In POWER-DOWN, the watchdog tick wakes us up for the next presence check.
+    if (Console.available() > 0) {
+      //TODO: Allow this state to be breakable by some special command / character.
+      //TODO: Or maybe even better - timeout!
+    }
   }
-  ibutton.reset_search();               //If we don't reset, the next ibutton.search will fail.
+  ibutton.reset_search();
+  S.println(F("[SUCCESS] An iButton device has been successfully detected!"));
 
-  //Match against the one in the current memory slot
-  
-  S.print(F("[INFO] Reading code from device slot... "));
-  S.print(activeMemSlot, HEX); S.print(" : ");
-  print_mem_name(activeMemSlot); S.print(" : ");
-  if (advancedMode) {                 //If in advanced mode,
-    print_mem(0, 8, activeMemSlot);     //print all of the 8 bytes...
-  } else {                            //If not in advanced mode however...
-    print_mem(0, 7, activeMemSlot);     //Don't print the last byte (CRC, a calculated cyclical redundancy check)
-    // print_mem(1, 7, activeMemSlot);     //Don't print the first byte (0x0C, family code) and last byte (CRC, a calculated cyclical redundancy check)
-  }
+  delay(250);               //Debounce delay. Adjust as needed.
+
+  S.println();
+}
+
+void advanced_command() { //Advanced mode
+  advancedMode = !advancedMode;
   S.println();
 
-  detect_iButton();
+  S.println(F("===Advanced mode==="));
+  if (advancedMode) {
+  S.println(F("[INFO] Active memory slot selection via serial console has been ENABLED."));
+  S.println(F("[INFO] Meaning you can now change memory slot by utilizing menu entry 'M'."));
+  S.println(F("[WARNING] As a consequence of that, it WON'T be possible to change active memory slot via GPIO!"));
+  S.println();
+  S.println(F("[INFO] You CAN now see & edit the first and last bytes in iButton addresses."));
+  S.println(F("[WARNING] Beware, that you can destroy your iButton by writing bad modification of these bytes!"));
+  } else {
+  S.println(F("[INFO] Active memory slot selection via serial console has been DISABLED."));
+  S.println(F("[INFO] Meaning active memory slots WILL be changing according to GPIO!"));
+  S.println();
+  S.println(F("[INFO] You now CAN NOT see & edit the first and last bytes in iButton addresses."));
+  }
+  update_slot();              //So that we'll switch active mem slot to one in accordance of the GPIO.
 
   S.println();
+}
 
-  bool mismatch = false;
-  for(int i = 0; i < 8; i++) {
-    if (EEPROM.read(i + (activeMemSlot << 5)) != addr[i]) {
-      mismatch = true;
-      S.print(F("Mismatch on index "));
-      S.print(i);
-      S.print(F(": "));
-      S.print(EEPROM.read(i + (activeMemSlot << 5)), HEX);
-      S.print(F("<->"));
-      S.println(addr[i], HEX);
-    }
+#if USE_OVERDRIVE == true && defined(__AVR__)
+void overdrive_command() { //Overdrive reads toggle
+  overdriveReads = !overdriveReads;
+  S.println(F("===OVERDRIVE speed reads==="));
+  if (overdriveReads) {
+    S.println(F("[INFO] Reads will try OVERDRIVE speed first, and fall back to STANDARD speed if nothing answers."));
+  } else {
+    S.println(F("[INFO] Reads are at STANDARD speed only."));
   }
   S.println();
-    
-  if (mismatch) {
-    S.println(F("[ERROR] An iButton address does not correspond to one saved in a memory slot!\n"));
-    return false;
+}
+#endif
+
+void statistics_command() { //Operation statistics
+  S.println(F("===Operation statistics (INFO)==="));
+  print_stats();
+  S.println();
+}
+
+void journal_command() { //Audit journal export
+  S.println(F("===JOURNAL of clone operations==="));
+  print_journal();
+  S.println();
+}
+
+void macros_command() { //Command macros
+  S.println(F("===Command macros==="));
+  if (Console.feeding()) {          //Its remaining characters would be taken for the macro menu input
+    Console.stop();
+    S.println(F("[ERROR] Macros can't be used from a macro! Macro stopped."));
+  } else {
+    macro_menu();
   }
+  S.println();
+}
 
-  S.println(F("[SUCCESS] An iButton address matches the one saved in a currently active memory slot!\n"));
-  return true;
+#if USE_MEMORY_REPORT == true && defined(__AVR__)
+void memory_report_command() { //RAM / stack report
+  S.println(F("===RAM / stack high-water marks (since boot)==="));
+  print_memory_report();
+  S.println();
 }
+#endif
 
-void function_caller() { //TODO: Merge this with the serial parser function?
-  switch (serial_choice) {          //Execute apropiate command 
-      case 0:                         //Show
-        S.println(F("===SHOW contents of the currently active memory slot==="));
-        update_slot();
-        if(slot_is_full(activeMemSlot)) {
-          S.print(F("[INFO] Reading code from device slot... "));
-          S.print(activeMemSlot, HEX); S.print(" : ");
-          print_mem_name(activeMemSlot); S.print(" : ");
-          if (advancedMode) {                 //If in advanced mode,
-          print_mem(0, 8, activeMemSlot);     //print all of the 8 bytes...
-          } else {                            //If not in advanced mode however...
-          print_mem(0, 7, activeMemSlot);     //Don't print the last byte (CRC, a calculated cyclical redundancy check)
-          // print_mem(1, 7, activeMemSlot);     //Don't print the first byte (0x0C, family code) and last byte (CRC, a calculated cyclical redundancy check)
-          }
-          S.println("\n");
-        }
-        else {
-          S.print("[ERROR] No code stored in slot ");
-          S.print(activeMemSlot, HEX);
-          S.println(" yet.\n");
-        }
-        break;
+#if USE_TRACE == true
+void trace_command() { //Trace recording toggle
+  S.println(F("===TRACE recording==="));
+  if (!traceOn) {
+    S.println(F("[INFO] Trace is ON - serial input, 1-Wire bus operations & EEPROM writes follow as binary records."));
+    S.println(F("[INFO] Enter 'T' again to stop it. Capture, decode & replay it with tools/trace."));
+    traceOn = true;
+    traceLost = 0;
+    traceLastUs = micros();
+    byte start[5] = {TRACE_VERSION, (byte)traceLastUs, (byte)(traceLastUs >> 8), (byte)(traceLastUs >> 16), (byte)(traceLastUs >> 24)};
+    trace_record(TRACE_START, start, sizeof(start));
+  } else {
+    trace_record(TRACE_STOP, 0, 0);
+    traceOn = false;
+    S.println(F("[INFO] Trace is OFF."));
+  }
+  S.println();
+}
+#endif
 
-      case 1:                         //Edit
-        S.println(F("===Manually EDITING the currently active memory slot==="));
-        if (advancedMode) {
-          edit_slot(activeMemSlot, 8);
-        } else {
-          edit_slot(activeMemSlot, 7);
-        }
-        break;
+void power_command() { //Power / idle mode
+  S.println(F("===POWER management==="));
+  print_power_stats();
+  S.println(F("[INFO] Write 0 to BUSY-wait, 1 to IDLE sleep or 2 to POWER-DOWN sleep between polls."));
+  S.println(F("[INFO] In POWER-DOWN, the serial input that wakes the device up is lost - up to ~11 characters (~1 ms at 115200 Bd)."));
+  S.println(F("[INFO] Send a single wake-up character first. After any serial input, the device stays in IDLE for 10 s."));
+  S.println(F("[INFO] Enter 'X' to keep the current idle mode."));
+  S.println();
+  {
+    wait_for_serial_input();
+    char ch = Console.read();
+    if (ch >= '0' && ch <= '2') {
+      idleMode = ch - '0';
+      memset(&powerStats, 0, sizeof(powerStats));   //Statistics are per idle mode
+      powerStats.lastWakeUs = micros();
+      S.print(F("[SUCCESS] Idle mode changed to: ")); S.println(idleMode);
+    } else if (toupper(ch) != 'X') {
+      S.println(F("[ERROR] Invalid input! Idle mode unchanged."));
+      clear_serial();
+    }
+  }
+  S.println();
+}
 
-      case 2:                         //Clear
-        S.println(F("===CLEAR the currently active memory slot==="));
-        update_slot();
-        S.print(F("[INFO] Clearing slot "));
-        S.print(activeMemSlot, HEX);
-        S.println("...");
-        
-        for(int x = 0; x < 16; x++) {
-          EEPROM.write(x + (activeMemSlot << 5), 0x00);
-        }
-          
-        S.print(F("[SUCCESS] Slot "));
-        S.print(activeMemSlot, HEX);
-        S.println(F(" cleared!\n"));
-        break;
+void clone_queue_command() { //Streaming clone queue
+  S.println(F("===Streaming CLONE QUEUE==="));
+  clone_queue();
+  S.println();
+}
 
-      case 3:                         //Dump
-        S.println(F("===DUMP all memory slots==="));
-        S.println(F("[INFO] Dumping all slots..."));
-        S.println();
-        dump_all_mem_slots_to_serial();
-        S.println();
-        S.println(F("[SUCCESS] Done dumping all slots!"));
-        S.println();
-        break;
+#if USE_EMULATION == true && defined(__AVR__)
+void emulate_command() { //iButton slave emulation
+  S.println(F("===EMULATE iButton from currently active memory slot==="));
+  emulate_iButton();
+  S.println();
+}
+#endif
 
-      case 4:                         //read iBtn
-        S.println(F("===READ FROM iButton to currently active memory slot==="));
-        S.println(F("[INFO] Reading from the iButton & saving to currently selected slot!"));
+#if USE_MULTI_PROBE == true
+void multi_probe_command() { //Multi-probe clone
+  S.println(F("===MULTI-PROBE clone from currently active memory slot==="));
+  multi_probe_clone();
+  S.println();
+}
+#endif
 
-        if (read_iButton()) {
-          S.println(F("[SUCCESS] Read was successful!"));
-        } else {
-          S.println(F("[ERROR] An error has occurred during an attemt to read the iButton!"));
-          S.println(F("[INFO] Check your electrical connections!"));
-        }
+void memory_select_command() { //Manual memory (activeMemSlot) change
+  //display all the slots?
 
-        S.println();
-        break;
-      
-      case 5:                         //write iBtn
-        S.println(F("===WRITE TO iButton from currently active memory slot==="));
-        S.println(F("[INFO] Reading from the currently selected slot & writing to the iButton!"));
-
-        if (write_iButton()) {
-          S.print(F("[SUCCESS] Data from the current memory slot ")); S.print(activeMemSlot); S.println(F(" should be successfully written to the iButton."));
-          S.println(F("[INFO] You can check by reading the iButton now!"));
-        } else {
-          S.println(F("[ERROR] An error has occurred during an attemt to write to the iButton!"));
-          S.println(F("[INFO] It might be that your currently selected slot is EMPTY!"));
-          S.println(F("[INFO] Check if reading does work. If not, "));
-          S.println(F("[INFO] check your electrical connections!"));
-        }
+  S.println(F("===Change active memory slot==="));
+  S.print(F("[INFO] Currently active memory slot is: ")); S.println(activeMemSlot, HEX);
+  S.println(F("[INFO] You can press 'W' to wipe all memory slots at once." ));
+  S.println(F("[INFO] Write 0-to-F to select active memory slot!"));
+  S.println(F("[INFO] You can enter 'L' to show list of the memory slots, \n[INFO] or enter 'X' to cancel!"));
+  S.println();
 
-        S.println();
-        break;
+  while(true) {
+    wait_for_serial_input();     //Wait while there are NO data in the serial buffer...
+    char ch = toUpperCase(Console.read());
+    if (ch == 'X') break;              //If it's 'X', cancel / break.
 
-      case 6:                         //list iBtn
-        S.println(F("===LIST / detect / read connected iButton==="));
-        if (detect_iButton()) {
-          S.println(F("[SUCCESS]"));
-        } else {
-          S.println(F("[ERROR] An error has occurred during an attemt to read the iButton!"));
-          S.println(F("[INFO] Check your electrical connections!"));
+    if (ch == 'L') {                   //If it's 'L', print the availble memory slots.
+      S.println(F("List of the availble memory slots:"));
+      dump_all_mem_slots_to_serial();
+      S.println();
+      continue;
+    }
+    if (ch == 'W') {                   //If it's 'W', prepare to WIPE ALL MEMORY SLOTS! "(W)IPE"
+      S.println(F("[WARNING] YOU ARE ATTEMTING TO WIPE ALL MEMORY SLOTS IN THE DEVICE'S MEMORY!"));
+      S.println(F("[WARNING] TO CONFIRM THIS OPERATION FINISH THE WORD \"(W)IPE\" (you've already wrote the \"W\")."));
+      S.println(F("[INFO] YOU MUST WRITE THE \"IPE\" IN CAPITAL LETTERS."));
+      S.println(F("[INFO] To skip this confirmation, you can just write \"WIPE\" the next time after selecting menu option 'm'."));
+      S.println();
+
+      uint8_t arraySize = sizeof(WIPE_CONFIRMATION) / sizeof(WIPE_CONFIRMATION[0]); //It's 3 for 'I', 'P', 'E'.
+      byte serialBuffer[arraySize];
+      for(int x = 0; x < arraySize; x++) {
+        wait_for_serial_input();
+        serialBuffer[x] = Console.read();
+        if (serialBuffer[x] != WIPE_CONFIRMATION[x]) {            //IF the letters - as they're coming in - doesn't match with the WIPE_CONFIRMATION, abort!
+          S.println(F("[ERROR] Invalid input! Wipe cancelled!"));
+          clear_serial();
+          /* Okay, so the break won't work here, as it breaks the FOR loop, not the WHILE loop.
+          * We might get away, with return, which might complicate something in the future though...
+          * And then, there is is this... https://en.cppreference.com/w/cpp/language/break#Explanation
+          * AKA "use goto". But I'd be crucified for this, not that much people will read this :D
+          */
+          return;
         }
-        S.println();
-        break;
+      }                                             //IF we got through the FOR cycle, means the serial input matches the WIPE_CONFIRMATION!
 
-      case 7:                         //wait iBtn
-        S.println(F("===Waiting for iButton device==="));
-        S.println(F("[WARNING] Code execution is being blocked until iButton device is detected!"));
-        S.println(F("[INFO] You can now queue commands and inputs for those commands."));
-        S.println(F("[INFO] On bad input, however, rest of the queued commands will be invalidated!"));
-        byte throwaway[8];
-        while(!ibutton.search(throwaway)) {
-          ibutton.reset_search();
-          yield();
-          delay(1);
-          if (Serial.available() > 0) {
-            //TODO: Allow this state to be breakable by some special command / character.
-            //TODO: Or maybe even better - timeout!
-          }
+      S.println(F("[INFO]======WIPING=NOW!======"));
+      for(byte memSlot = 0x00; memSlot < 0x10; memSlot++) { //FOR every slot, one at a time...
+        for(int x = 0; x < 16; x++) {
+          eeprom_write(x + (memSlot << 5), 0x00);     //CLEAR one.
         }
-        ibutton.reset_search();
-        S.println(F("[SUCCESS] An iButton device has been successfully detected!"));
+      }
+      slot_changed();
 
-        delay(250);               //Debounce delay. Adjust as needed.
+      S.println(F("[SUCCESS] All memory slots in EEPROM has been cleared!"));
+      dump_all_mem_slots_to_serial();
+      S.println();
+      break;
+    }
+    if (set_active_mem_slot(ch)) {    //If the active memory slot change was successfull...
+      S.print(F("[SUCCESS] The currently active memory slot was changed to: "));
+      S.println(activeMemSlot, HEX);
+      break;
+    } 
+    else {                          //But if it wasn't...
+      S.print(F("[ERROR] Invalid input! ")); S.print(F("( ")); 
+      if ((ch == 13) || (ch == 10) || (ch == 8)) {  S.print(F("RETURN")); } else {  S.print(ch);  } //IF LF, CR or BackSpace...
+      S.println(F(" )"));
+
+      clear_serial();
+      S.println();
+      break;
+    }
+  }
+  S.println();
+}
 
-        S.println();
-        break;
+void blank_type_command() { //Blank type / writing driver selection
+  S.println(F("===Select BLANK type==="));
+  for (byte x = 0; x < BLANK_DRIVER_COUNT; x++) {
+    S.print(x); S.print(" : "); print_blank_driver(x);
+    if (forcedBlankDriver == x) S.print(F("  <<SELECTED>>  "));
+    S.println();
+  }
+  S.print(F("A : Auto-detect before every write"));
+  if (forcedBlankDriver < 0) S.print(F("  <<SELECTED>>  "));
+  S.println();
+  S.println(F("[INFO] Write the number of the blank type, 'A' for auto-detection, or 'X' to cancel!"));
+  S.println(F("[WARNING] Writing with a wrong blank type can destroy the iButton!"));
+  {
+    wait_for_serial_input();
+    char ch = toupper(Console.read());
+    if (ch == 'A') {
+      forcedBlankDriver = -1;
+      S.println(F("[SUCCESS] Blank type will be auto-detected."));
+    } else if (ch >= '0' && ch < '0' + (int)BLANK_DRIVER_COUNT) {
+      forcedBlankDriver = ch - '0';
+      S.print(F("[SUCCESS] Blank type set to: ")); print_blank_driver(forcedBlankDriver); S.println();
+    } else if (ch != 'X') {
+      S.println(F("[ERROR] Invalid input! Blank type unchanged."));
+      clear_serial();
+    }
+  }
+  S.println();
+}
 
-      case 8:                         //Advanced mode
-        advancedMode = !advancedMode;
-        S.println();
-
-        S.println(F("===Advanced mode==="));
-        if (advancedMode) {
-        S.println(F("[INFO] Active memory slot selection via serial console has been ENABLED."));
-        S.println(F("[INFO] Meaning you can now change memory slot by utilizing menu entry 'M'."));
-        S.println(F("[WARNING] As a consequence of that, it WON'T be possible to change active memory slot via GPIO!"));
-        S.println();
-        S.println(F("[INFO] You CAN now see & edit the first and last bytes in iButton addresses."));
-        S.println(F("[WARNING] Beware, that you can destroy your iButton by writing bad modification of these bytes!"));
-        } else {
-        S.println(F("[INFO] Active memory slot selection via serial console has been DISABLED."));
-        S.println(F("[INFO] Meaning active memory slots WILL be changing according to GPIO!"));
-        S.println();
-        S.println(F("[INFO] You now CAN NOT see & edit the first and last bytes in iButton addresses."));
-        }
-        update_slot();              //So that we'll switch active mem slot to one in accordance of the GPIO.
+/* The console commands, one line each: key, advanced mode only, handler & its help line in the menu ("Enter 'key' " + help).
+ * They all end up in COMMAND_TABLE, and the menu, the advanced mode gating & the dispatch in serial_parser() only go through
+ * that, so a new command is just its handler & a line here. A key used twice is a compile error (see command_keys_unique()).
+ * Commands of optional features have their own lists, empty when the feature is disabled.
+ */
+#if USE_OVERDRIVE == true && defined(__AVR__)
+#define OVERDRIVE_COMMANDS(X) \
+  X('O', false, overdrive_command,     "to toggle OVERDRIVE speed reads (faster, for DS199x devices that support it).")
+#else
+#define OVERDRIVE_COMMANDS(X)
+#endif
+#if USE_MEMORY_REPORT == true && defined(__AVR__)
+#define MEMORY_REPORT_COMMANDS(X) \
+  X('H', false, memory_report_command, "to show RAM / stack High-water marks since boot.")
+#else
+#define MEMORY_REPORT_COMMANDS(X)
+#endif
+#if USE_EMULATION == true && defined(__AVR__)
+#define EMULATION_COMMANDS(X) \
+  X('U', false, emulate_command,       "to emUlate DS1990A iButton with the ID from currently active memory slot.")
+#else
+#define EMULATION_COMMANDS(X)
+#endif
+#if USE_TRACE == true
+#define TRACE_COMMANDS(X) \
+  X('T', false, trace_command,         "to toggle TRACE recording (binary records of serial input, 1-Wire bus & EEPROM writes, see tools/trace).")
+#else
+#define TRACE_COMMANDS(X)
+#endif
+#if USE_MULTI_PROBE == true
+#define MULTI_PROBE_COMMANDS(X) \
+  X('N', false, multi_probe_command,   "to clone currently active memory slot to blanks on all the probes (multi-probe fixture).")
+#else
+#define MULTI_PROBE_COMMANDS(X)
+#endif
 
-        S.println();
-        break;
+#define COMMANDS(X) \
+  X('L', false, list_command,          "to LIST / detect / read connected iButton.") \
+  X('S', false, show_command,          "to SHOW contents of the currently active memory slot.") \
+  X('R', false, read_command,          "to READ FROM iButton to currently active memory slot.") \
+  X('W', false, write_command,         "to WRITE TO iButton from currently active memory slot.") \
+  X('V', false, verify_command,        "to VERIFY iButton address against currently active memory slot.") \
+  X('E', false, edit_command,          "to EDIT the currently active memory slot.") \
+  X('C', false, clear_command,         "to CLEAR the currently active memory slot.") \
+  X('D', false, dump_command,          "to DUMP all memory slots.") \
+  X('G', false, memory_dump_command,   "to GET (dump) the whole memory of connected memory iButton (DS1992-DS1996...).") \
+  X('|', false, wait_command,          "(pipe) to stop code execution, until iButton is detected (allows for batch operation / command queuing).") \
+  X('A', false, advanced_command,      "to enter / toggle ADVANCED options mode.") \
+  OVERDRIVE_COMMANDS(X) \
+  X('I', false, statistics_command,    "to show operation statistics (INFO) - reads, writes, failures & write latency per slot and family code.") \
+  X('J', false, journal_command,       "to export the JOURNAL of reads, writes & verifies (CSV, oldest first).") \
+  X('K', false, macros_command,        "to run, record or clear stored command macros.") \
+  MEMORY_REPORT_COMMANDS(X) \
+  TRACE_COMMANDS(X) \
+  X('P', false, power_command,         "to show POWER / sleep statistics and change the idle mode.") \
+  X('Q', false, clone_queue_command,   "to start the streaming clone QUEUE (writes host-supplied IDs to blanks, without using memory slots).") \
+  EMULATION_COMMANDS(X) \
+  MULTI_PROBE_COMMANDS(X) \
+  X('M', true,  memory_select_command, "to change active memory slot.") \
+  X('B', true,  blank_type_command,    "to select the BLANK type (writing driver), or let it be auto-detected.")
+
+struct Command {                  //Menu entry & its handler, in PROGMEM
+  char key;
+  bool advancedOnly;              //Listed under "Advanced commands" & ignored outside of the advanced mode
+  void (*handler)();
+  const char *help;               //PROGMEM string
+};
+
+#define COMMAND_HELP(key, advancedOnly, handler, help) const char handler##_help[] PROGMEM = help;
+#define COMMAND_ENTRY(key, advancedOnly, handler, help) {key, advancedOnly, handler, handler##_help},
+#define COMMAND_KEY(key, advancedOnly, handler, help) key,
+
+COMMANDS(COMMAND_HELP)
+const PROGMEM Command COMMAND_TABLE[] = {COMMANDS(COMMAND_ENTRY)};
+#define COMMAND_COUNT (sizeof(COMMAND_TABLE) / sizeof(COMMAND_TABLE[0]))
+
+constexpr char COMMAND_KEYS[] = {COMMANDS(COMMAND_KEY)};  //Compile time only, COMMAND_TABLE can't be read in a constexpr
+constexpr bool command_keys_unique(byte x = 0, byte y = 1) {  //No key of COMMAND_KEYS[x] on is there again after it
+  return x + 1 >= sizeof(COMMAND_KEYS) ? true
+       : y >= sizeof(COMMAND_KEYS) ? command_keys_unique(x + 1, x + 2)
+       : COMMAND_KEYS[x] != COMMAND_KEYS[y] && command_keys_unique(x, y + 1);
+}
+static_assert(command_keys_unique(), "A command key is used twice in COMMANDS()");
+
+void print_commands(bool advancedOnly) {
+  Command command;
+  for (byte x = 0; x < COMMAND_COUNT; x++) {
+    memcpy_P(&command, &COMMAND_TABLE[x], sizeof(Command));
+    if (command.advancedOnly != advancedOnly) continue;
+    S.print(F("Enter '")); S.print(command.key); S.print(F("' "));
+    S.println((const __FlashStringHelper *)command.help);
+  }
+}
 
-      case 9:                         //Manual memory (activeMemSlot) change
-        if (!advancedMode) break; //TODO
-
-        //display all the slots?
-        
-        S.println(F("===Change active memory slot==="));
-        S.print(F("[INFO] Currently active memory slot is: ")); S.println(activeMemSlot, HEX);
-        S.println(F("[INFO] You can press 'W' to wipe all memory slots at once." ));
-        S.println(F("[INFO] Write 0-to-F to select active memory slot!"));
-        S.println(F("[INFO] You can enter 'L' to show list of the memory slots, \n[INFO] or enter 'X' to cancel!"));
-        S.println();
-
-        while(true) {
-          wait_for_serial_input();     //Wait while there are NO data in the serial buffer...
-          char ch = toUpperCase(Serial.read());
-          if (ch == 'X') break;              //If it's 'X', cancel / break.
-
-          if (ch == 'L') {                   //If it's 'L', print the availble memory slots.
-            S.println(F("List of the availble memory slots:"));
-            dump_all_mem_slots_to_serial();
-            S.println();
-            continue;
-          }
-          if (ch == 'W') {                   //If it's 'W', prepare to WIPE ALL MEMORY SLOTS! "(W)IPE"
-            S.println(F("[WARNING] YOU ARE ATTEMTING TO WIPE ALL MEMORY SLOTS IN THE DEVICE'S MEMORY!"));
-            S.println(F("[WARNING] TO CONFIRM THIS OPERATION FINISH THE WORD \"(W)IPE\" (you've already wrote the \"W\")."));
-            S.println(F("[INFO] YOU MUST WRITE THE \"IPE\" IN CAPITAL LETTERS."));
-            S.println(F("[INFO] To skip this confirmation, you can just write \"WIPE\" the next time after selecting menu option 'm'."));
-            S.println();
-
-            uint8_t arraySize = sizeof(WIPE_CONFIRMATION) / sizeof(WIPE_CONFIRMATION[0]); //It's 3 for 'I', 'P', 'E'.
-            byte serialBuffer[arraySize];
-            for(int x = 0; x < arraySize; x++) {
-              wait_for_serial_input();
-              serialBuffer[x] = Serial.read();
-              if (serialBuffer[x] != WIPE_CONFIRMATION[x]) {            //IF the letters - as they're coming in - doesn't match with the WIPE_CONFIRMATION, abort!
-                S.println(F("[ERROR] Invalid input! Wipe cancelled!"));
-                clear_serial();
-                /* Okay, so the break won't work here, as it breaks the FOR loop, not the WHILE loop.
-                * We might get away, with return, which might complicate something in the future though...
-                * And then, there is is this... https://en.cppreference.com/w/cpp/language/break#Explanation
-                * AKA "use goto". But I'd be crucified for this, not that much people will read this :D
-                */
-                return;
-              }
-            }                                             //IF we got through the FOR cycle, means the serial input matches the WIPE_CONFIRMATION!
-            
-            S.println(F("[INFO]======WIPING=NOW!======"));
-            for(byte memSlot = 0x00; memSlot < 0x10; memSlot++) { //FOR every slot, one at a time...
-              for(int x = 0; x < 16; x++) {
-                EEPROM.write(x + (memSlot << 5), 0x00);     //CLEAR one.
-              }
-            }
-
-            S.println(F("[SUCCESS] All memory slots in EEPROM has been cleared!"));
-            dump_all_mem_slots_to_serial();
-            S.println();
-            break;
-          }
-          if (set_active_mem_slot(ch)) {    //If the active memory slot change was successfull...
-            S.print(F("[SUCCESS] The currently active memory slot was changed to: "));
-            S.println(activeMemSlot, HEX);
-            break;
-          } 
-          else {                          //But if it wasn't...
-            S.print(F("[ERROR] Invalid input! ")); S.print(F("( ")); 
-            if ((ch == 13) || (ch == 10) || (ch == 8)) {  S.print(F("RETURN")); } else {  S.print(ch);  } //IF LF, CR or BackSpace...
-            S.println(F(" )"));
-
-            clear_serial();
-            S.println();
-            break;
-          }
-        }
-        S.println();
-        break;
+void printMenu() { //Serial menu...
+  S.println(F("===Welcome to iButton Cloner Serial Console==="));
+  print_commands(false);
+  if (advancedMode) {
+  S.println();
+  S.println(F("===Advanced commands==="));
+  print_commands(true);
+  }
+  S.println();
+}
 
-      case 10:
-        verify_iButton();
-        break;
-      
-      default:
-        break;
+void serial_parser() { //Reads one character off the console & runs the command it stands for
+  STACK_PROBE("serial_parser");
+  Console.settle(30);                 //wait for serial to catch up
+  if(Console.available() > 0) {
+    byte currChar = toupper(Console.read());  //read (pop) a byte off the serial buffer & capitalize it
+    Command command;
+    for (byte x = 0; x < COMMAND_COUNT; x++) {
+      memcpy_P(&command, &COMMAND_TABLE[x], sizeof(Command));
+      if (command.key != currChar) continue;
+      if (!command.advancedOnly || advancedMode) command.handler();
+      return;
+    }
+    SDBGprint("You have written: ");  //Not a command
+    SDBGprintln((char)currChar);
+    SDBGprintln(currChar, HEX);
+    SDBGprintln(currChar);
   }
-  serial_choice = -1; //It was previously at the end of every switch statement, so, let's try doing it always, anyways. Less code duplicity.
 }
 
 void setup() {
   #if USE_SERIAL == true
   Serial.begin(115200);
+  #if CONSOLE_TX_ISR == true
+  OCR0A = 0x80;                 //Any value, Timer0 passes it once per 1 ms overflow period. (No PWM is used on the OC0A pin.)
+  TIMSK0 |= _BV(OCIE0A);        //Console output drain
+  #endif
   delay(500);
   #endif
 
@@ -1014,24 +3204,32 @@ void setup() {
   pinMode(WRITE, INPUT_PULLUP); //internal pullup
 
   for(int x = 0; x < 4; x++) {
-    pinMode(SLOT[x], INPUT_PULLUP);
+    pinMode(pgm_read_word(&SLOT[x]), INPUT_PULLUP);
   }
+  slot_init();
 
   digitalWrite(RED, LOW);
   digitalWrite(GREEN, LOW); //off
 
+#if USE_OVERDRIVE == true && defined(__AVR__)
+  od_init();
+#endif
+
+  stats_init();
+  journal_init();
+
   delay(150);   //Wait a bit, so we won't start printing menu too soon
+  powerStats.lastWakeUs = micros();
   printMenu();  //print serial console welcome message
 }
 
 void loop() {
-  if (Serial.available() > 0) {       //if there are data in the serial buffer...
-    serial_parser();                  //Looks up, per 1 character, if the serial input is a command, otherwise prints input back
+  if (Console.available() > 0) {       //if there are data in the serial buffer...
+    serial_parser();                  //Looks up, per 1 character, if the serial input is a command & runs it
 
     // clear_serial();                   //Clear serial, but this will prevent batch execution of commands, so it's disabled
-    function_caller();
     
-    if (!Serial.available()) printMenu();
+    if (!Console.available()) printMenu();
   }
 
   else {                                        //Serial buffer is empty (no incoming serial data present)
@@ -1039,6 +3237,7 @@ void loop() {
     write_pressed = !digitalRead(WRITE);
   
     if(read_pressed && write_pressed) {         //IF both buttons are pressed & held down, clear current mem position 
+      update_slot();                            //At the press, the held WRITE reaches the selector during the blinks (see SLOT[])
       for(int x = 0; x < 3; x++) {
         blinkPin(RED, 1, 500);
         read_pressed = !digitalRead(READ);
@@ -1048,8 +3247,9 @@ void loop() {
         }
       }
       for(int i = 0; i < 16; i++) {
-        EEPROM.write(i + (activeMemSlot << 5), 0x00); //Clear ALL 16 memory slots by writing zeroes to them
+        eeprom_write(i + (activeMemSlot << 5), 0x00); //Clear ALL 16 memory slots by writing zeroes to them
       }
+      slot_changed();
       blinkPin(GREEN, 3, 150);
     }
 
@@ -1058,10 +3258,10 @@ void loop() {
     }
 
     else if(write_pressed) {                //Write button was pressed
-      write_iButton();
+      write_iButton();                      //Pins the slot right away, the one selected before the press (see SLOT[])
     }
     else {
-      delay(1);
+      idle_sleep(false);                    //Sleep until a button, slot selector or serial input wakes us up
     }
   }
 } 
@@ -0,0 +1,47 @@
+# batch_clone against the host firmware over a pty: cmake -DHOST_FIRMWARE=... -DBATCH_CLONE=... -DIDS=... -P batch_clone_test.cmake
+set(BLANK 01FFFFFFFFFFFF2F)
+
+function(run_batch name expected_result)
+  execute_process(COMMAND ${HOST_FIRMWARE} --speed 4 ${ARGN}
+                  OUTPUT_VARIABLE out ERROR_VARIABLE out RESULT_VARIABLE result TIMEOUT 300)
+  message(STATUS "--- ${name}\n${out}")
+  if(NOT result EQUAL expected_result)
+    message(FATAL_ERROR "${name}: exit status ${result}, expected ${expected_result}")
+  endif()
+  set(out "${out}" PARENT_SCOPE)
+endfunction()
+
+function(expect name text)
+  foreach(pattern ${ARGN})
+    if(NOT text MATCHES "${pattern}")
+      message(FATAL_ERROR "${name}: no match for \"${pattern}\"")
+    endif()
+  endforeach()
+endfunction()
+
+# Every ID pipelined with the next one's staging, the read-only 3rd fob fails the verify
+run_batch(pipelined 1 --blank ${BLANK} --blank ${BLANK} --blank ${BLANK},ro --blank ${BLANK}
+          --pty -- ${BATCH_CLONE} -v {} ${IDS})
+expect(pipelined "${out}"
+  ">> \\|WVMFE0x01, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x75\n"   # 49 Bytes, fits the 63 Byte RX buffer
+  "\\[ +1/4\\] 01A1B2C3D4E5F68F first +OK"
+  "\\[ +2/4\\] 0111223344556675 second +OK"
+  "\\[ +3/4\\] 01000000000BAD4C bad +VERIFY FAILED"
+  "\\[ +4/4\\] 01AABBCCDDEEFF2F last +OK"
+  "<< \\[SUCCESS\\][^\n]*\n[^>]*>> L\n"                         # Still on the contacts: polled again...
+  "attemt to read"                                              # ...until it's taken off
+  "\\[DONE\\] OK: 3, verify failed: 1, write failed: 0, not done: 0"
+  "throughput: [1-9][0-9]* fobs/hour")
+
+# An RX buffer too small for the pipelining: the staging goes on its own after the result
+run_batch(unpipelined 1 --blank ${BLANK} --blank ${BLANK} --pty -- ${BATCH_CLONE} -v -r 40 -t 3 {} ${IDS})
+expect(unpipelined "${out}"
+  ">> \\|WV\n"
+  "\\[DONE\\] OK: 2, verify failed: 0, write failed: 0, not done: 2")
+
+# No more fobs: the batch stops at the fob timeout
+run_batch(timeout 1 --blank ${BLANK} --pty -- ${BATCH_CLONE} -t 3 {} ${IDS})
+expect(timeout "${out}"
+  "\\[ +2/4\\] 0111223344556675 second +TIMEOUT"
+  "still waits for a fob"
+  "\\[DONE\\] OK: 1, verify failed: 0, write failed: 0, not done: 3")
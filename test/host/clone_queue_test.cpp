@@ -0,0 +1,88 @@
+/*
+ * clone_queue_test - the streaming clone queue ('Q') of src/main.cpp against a host that keeps to its credits
+ *
+ * The host sends only as many ID lines as the last [CREDIT] allowed, the fobs (host_bus.cpp) come one after the other.
+ * Then a host that ignores the credits: what doesn't fit the queue is dropped & reported, 'X' aborts.
+ */
+#include "host.h"
+#include "test.h"
+
+#include <EEPROM.h>
+
+void clone_queue();
+
+#define QUEUE_SIZE 8                    //CLONE_QUEUE_SIZE of the firmware
+#define RX_LINES 3                      //CLONE_QUEUE_RX_LINES, (SERIAL_RX_BUFFER_SIZE - 1) / 17
+#define IDS 10
+
+static int sent = 0, queued = 0, results = 0, credits = 0;
+static bool dotSent = false, overCredit = false;
+
+static std::string id_line(int i) {     //14 hex digits, the firmware adds the CRC
+  char line[20];
+  snprintf(line, sizeof(line), "01000000%06X\n", i + 1);
+  return line;
+}
+
+static void keep_to_credits(const std::string &line) {
+  int n;
+  if (sscanf(line.c_str(), "[CREDIT] %d", &n) == 1) {
+    credits++;
+    if (n < 1 || n > RX_LINES || (queued - results) + n > QUEUE_SIZE) overCredit = true;
+    for (; n > 0 && sent < IDS; n--) host_serial_send(id_line(sent++));
+    if (sent == IDS && !dotSent) {
+      host_serial_send(".\n");
+      dotSent = true;
+    }
+  } else if (line.compare(0, 9, "[QUEUED] ") == 0) {
+    queued++;
+    if (queued - results > QUEUE_SIZE) overCredit = true;
+  } else if (line.compare(0, 9, "[RESULT] ") == 0) {
+    char expected[64];
+    snprintf(expected, sizeof(expected), "[RESULT] #%d OK 0x01, 0x00, 0x00, 0x00, 0x%02X, 0x%02X, 0x%02X, ",
+             results + 1, (results + 1) >> 16, ((results + 1) >> 8) & 0xFF, (results + 1) & 0xFF);
+    CHECK(line.compare(0, strlen(expected), expected) == 0, "a result out of order, or not written");
+    results++;
+  }
+}
+
+int main() {
+  host_begin();
+  for (int i = 0; i < IDS; i++) host_add_blank("01FFFFFFFFFFFF2F", true);
+  host_blank_timing(500, 500);
+  host_serial_output(console_output);
+  setup();
+
+  uint8_t slots[0x200];
+  memcpy(slots, hostEeprom, sizeof(slots));
+
+  on_line = keep_to_credits;
+  output.clear();
+  clone_queue();
+  delay(100);                           //The rest of the output leaves the console queue meanwhile
+  CHECK(results == IDS, "not every ID was written");
+  CHECK(!overCredit, "a credit beyond the free room in the queue");
+  CHECK(credits > IDS / RX_LINES, "the credits weren't granted in parts");
+  CHECK(output.find("[ERROR]") == std::string::npos, "an error while the host kept to the credits");
+  CHECK(output.find("[DONE] Written: 10, failed: 0") != std::string::npos, "no [DONE] with the totals");
+  bool slotsKept = true;
+  for (int x = 0; x < 0x200; x++) {     //The slots' code & name, the journal is in the upper half of every 32 Bytes
+    if ((x & 0x10) == 0 && hostEeprom[x] != slots[x]) slotsKept = false;
+  }
+  CHECK(slotsKept, "the queue wrote to the memory slots");
+
+  on_line = nullptr;                    //All at once, no fobs left
+  output.clear();
+  for (int i = 0; i < QUEUE_SIZE + 2; i++) host_serial_send(id_line(i));
+  host_serial_send("X\n");
+  clone_queue();
+  delay(100);
+  size_t full = output.find("[ERROR] Queue is full, line dropped!");
+  CHECK(full != std::string::npos && output.find("[ERROR] Queue is full", full + 1) != std::string::npos,
+        "the 2 lines beyond the queue weren't reported");
+  CHECK(output.find("[QUEUED] #8") != std::string::npos && output.find("[QUEUED] #9") == std::string::npos,
+        "the queue didn't take exactly its size");
+  CHECK(output.find("Dropped queued IDs: 8") != std::string::npos, "the abort didn't drop the queued IDs");
+
+  return test_result("clone_queue_test");
+}
@@ -0,0 +1,75 @@
+/*
+ * emulation_test - the DS1990A slave emulation ('U') of src/main.cpp against the master of the OneWire library
+ *
+ * The master (onewire_master.cpp, the library's reset / bit / search routines) is on another pin wired to IBUTTON,
+ * the firmware's pin change interrupt answers it in the same simulated time (wire.cpp).
+ */
+#include "host.h"
+#include "test.h"
+#include "wire.h"
+
+#include <OneWire.h>
+
+void emu_start(const byte rom[8]);
+void emu_stop();
+extern volatile unsigned int emuResets, emuReads, emuSearches;
+
+static OneWire master(WIRE_MASTER_PIN);
+
+static void read_rom(byte rom[8], int bits) {   //The first bits of the ID after a Read ROM
+  memset(rom, 0, 8);
+  for (int i = 0; i < bits; i++) {
+    if (master.read_bit()) rom[i >> 3] |= 1 << (i & 7);
+  }
+}
+
+int main() {
+  const byte rom[8] = {0x01, 0xA1, 0xB2, 0xC3, 0xD4, 0xE5, 0xF6, 0x8F};
+  byte got[8];
+  host_begin();
+  wire_begin();
+  emu_start(rom);
+
+  CHECK(master.reset(), "no presence after a reset");
+  master.write(0x33);
+  read_rom(got, 64);
+  CHECK(memcmp(got, rom, 8) == 0, "Read ROM gave a different ID");
+
+  master.reset_search();
+  CHECK(master.search(got) && memcmp(got, rom, 8) == 0, "Search ROM gave a different ID");
+  CHECK(!master.search(got), "Search ROM found a second device");
+
+  CHECK(master.reset(), "no presence before the interrupted Read ROM");
+  master.write(0x33);
+  read_rom(got, 12);                    //The 13th bit is a 0: the slave answers the reset as a read slot first
+  CHECK(master.reset(), "no presence after a reset in the middle of Read ROM");
+  master.write(0x33);
+  read_rom(got, 64);
+  CHECK(memcmp(got, rom, 8) == 0, "Read ROM after a reset in the middle of it gave a different ID");
+
+  CHECK(master.reset(), "no presence before the interrupted Search ROM");
+  master.write(0xF0);
+  for (int i = 0; i < 5; i++) {
+    byte bit = master.read_bit();
+    master.read_bit();
+    master.write_bit(bit);
+  }
+  master.read_bit();                    //A reset after the bit, in place of its complement
+  CHECK(master.reset(), "no presence after a reset in the middle of Search ROM");
+
+  master.skip();                        //Skip ROM isn't emulated, the slave stays off the bus until the next reset
+  for (int i = 0; i < 8; i++) got[i] = master.read();
+  static const byte released[8] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+  CHECK(memcmp(got, released, 8) == 0, "the slave answered after an unknown ROM command");
+  CHECK(master.reset(), "no presence after an unknown ROM command");
+
+  CHECK(emuResets == 7, "reset count");
+  CHECK(emuReads == 2, "Read ROM count");
+  CHECK(emuSearches == 1, "Search ROM count");
+
+  emu_stop();
+  CHECK(!(PCMSK0 & digitalPinToBitMask(WIRE_SLAVE_PIN)), "pin change interrupt still enabled after the emulation");
+  CHECK(!master.reset(), "presence after the emulation stopped");
+
+  return test_result("emulation_test");
+}
@@ -0,0 +1,350 @@
+/*
+ * Host build of the firmware - the simulated MCU around src/main.cpp
+ *
+ * Time is simulated: it only moves on with delay() / delayMicroseconds(), sleep, the 1-Wire bus operations
+ * (their real duration) and polling, so a run is the same every time. With host_pace() the simulation
+ * is slowed down to a multiple of the real time, for talking to a host tool over a pty.
+ *
+ * What is on the 1-Wire contacts is up to the rest of the build: the fobs of host_bus.cpp, or a master on another pin (wire.cpp).
+ *
+ * host_replay() feeds the first session of a trace ('T' records, see tools/trace) back instead: the serial input arrives
+ * when the recording noticed it (its SERIAL_RX records, at the same time after boot), the 1-Wire bus results are the
+ * recorded ones, and the bus & EEPROM writes have to be the recorded ones, in the recorded order. Started from the same
+ * EEPROM image, with the 'T' right at boot like the recording, the firmware does exactly the same again.
+ */
+#include "host.h"
+
+#include <EEPROM.h>
+#include <OneWire.h>
+
+#include <errno.h>
+#include <unistd.h>
+
+#include <vector>
+
+unsigned long hostUs = 0;
+static unsigned hostSpeed = 0;
+static unsigned long unpacedUs = 0;     //Host time not slept for yet
+
+volatile uint8_t SREG, MCUSR, SMCR, PRR, EECR;
+volatile uint8_t PCICR, PCIFR, PCMSK0, PCMSK1, PCMSK2, EIMSK, EICRA, EIFR;
+volatile uint8_t TIMSK0, OCR0A, WDTCSR;
+volatile uint8_t hostPin[5], hostDdr[5], hostPort[5];
+uint8_t hostEeprom[E2END + 1];
+HardwareSerial Serial;
+
+/* The RAM report ('H') reads the AVR linker symbols & the stack pointer: they point to a 2 kB array here */
+uint8_t hostRam[RAMEND - 0xFF];
+volatile uintptr_t SP = (uintptr_t)(hostRam + sizeof(hostRam) - 0x100);
+char *__brkval = 0;
+asm(".globl hostDataStart\n .set hostDataStart, hostRam\n"
+    ".globl hostHeapStart\n .set hostHeapStart, hostRam + 0x300\n"
+    ".globl hostStack\n .set hostStack, hostRam + 0x7FF\n");
+
+void (*hostAdvance)(unsigned long us) = nullptr;
+
+static void host_advance(unsigned long us) {
+  if (hostAdvance) {
+    hostAdvance(us);
+  } else {
+    hostUs += us;
+  }
+  if (hostSpeed == 0) return;
+  unpacedUs += us;
+  if (unpacedUs >= 1000UL * hostSpeed) {
+    usleep(unpacedUs / hostSpeed);
+    unpacedUs = 0;
+  }
+}
+
+void host_pace(unsigned speed) {
+  hostSpeed = speed;
+}
+
+unsigned long micros() {
+  return hostUs++;
+}
+
+volatile uint8_t *host_timer0() {
+  static volatile uint8_t count;
+  host_advance(1);
+  count = hostUs / 4;
+  return &count;
+}
+
+unsigned long millis() {
+  return micros() / 1000;
+}
+
+void delay(unsigned long ms) {
+  while (ms--) {                        //The core calls yield() while it waits
+    host_advance(1000);
+    yield();
+  }
+}
+
+void delayMicroseconds(unsigned int us) {
+  host_advance(us);
+}
+
+void host_sleep() {                     //Woken up by the next 1 ms Timer0 interrupt at the latest
+  host_advance(1000);
+}
+
+extern "C" void __attribute__((weak)) yield(void) {}
+
+/* Serial port */
+static std::string rxData;
+static size_t rxRead = 0;
+static unsigned long rxGapUs = 0;
+static int serialFd = -1;
+static void (*serialClosed)();
+static void (*serialOut)(uint8_t c) = nullptr;
+
+/* Trace replay */
+static const char *const TRACE_NAMES[] = {"?", "START", "SERIAL_IN", "BUS_RESET", "BUS_WRITE", "BUS_READ", "BUS_WRITE_BIT",
+                                          "BUS_READ_BIT", "BUS_SEARCH", "PULSES", "EEPROM_WRITE", "LOST", "STOP", "SERIAL_RX"};
+static const int TRACE_PAYLOAD[] = {0, 5, 1, 2, 2, 2, 2, 2, 10, 2, 3, 2, 0, 1};
+#define TRACE_TYPES 14
+#define TRACE_VERSION 2
+
+struct Replayed {
+  int type;
+  unsigned long at;                     //micros() it was recorded at
+  uint8_t payload[10];
+};
+static std::vector<Replayed> replay;   //Everything but START, PULSES & STOP: the firmware's own output
+static size_t replayNext = 0;
+static std::string replayInput;        //The SERIAL_IN Bytes...
+static size_t replayInputAt = 0;       //...and how many have arrived
+
+bool host_replay(const std::string &trace, std::string &error) {
+  const uint8_t *data = (const uint8_t *)trace.data();
+  bool started = false;
+  unsigned long at = 0, noticed = 0;
+  for (size_t pos = 0; pos + 1 < trace.size(); ) {
+    if (data[pos] != 0xF5 || (!started && data[pos + 1] != TRACE_START)) {
+      pos++;
+      continue;
+    }
+    int type = data[pos + 1];
+    if (type == 0x00) {                 //An escaped text Byte
+      pos += 2;
+      continue;
+    }
+    if (type >= TRACE_TYPES) {
+      error = "unknown record type " + std::to_string(type);
+      return false;
+    }
+    pos += 2;
+    unsigned long delta = 0;
+    for (int shift = 0; pos < trace.size(); shift += 7) {
+      delta |= (unsigned long)(data[pos] & 0x7F) << shift;
+      if (!(data[pos++] & 0x80)) break;
+    }
+    if (pos + TRACE_PAYLOAD[type] > trace.size()) break; //Cut short
+    Replayed record;
+    record.type = type;
+    memcpy(record.payload, data + pos, TRACE_PAYLOAD[type]);
+    pos += TRACE_PAYLOAD[type];
+    if (type == TRACE_START) {
+      if (started) break;               //Only the first session
+      if (record.payload[0] != TRACE_VERSION) {
+        error = "trace format version " + std::to_string(record.payload[0]) + ", expected " + std::to_string(TRACE_VERSION);
+        return false;
+      }
+      started = true;
+      at = record.payload[1] | record.payload[2] << 8 | (unsigned long)record.payload[3] << 16 | (unsigned long)record.payload[4] << 24;
+    }
+    at += delta;
+    record.at = at;
+    if (type == TRACE_STOP) break;
+    if (type == TRACE_LOST) {
+      error = "records were lost while recording, it can't be replayed";
+      return false;
+    }
+    if (type == TRACE_SERIAL_IN) replayInput += (char)record.payload[0];
+    if (type == TRACE_SERIAL_RX) noticed += record.payload[0];
+    if (type != TRACE_START && type != TRACE_PULSES) replay.push_back(record);
+  }
+  if (!started) {
+    error = "no trace in it";
+    return false;
+  }
+  replayInputAt = replayInput.size() > noticed ? replayInput.size() - noticed : 0;  //Already there at the START
+  rxData = "T" + replayInput.substr(0, replayInputAt);  //The 'T' that started the trace isn't recorded
+  rxRead = 0;
+  rxGapUs = 0;
+  return true;
+}
+
+static bool replaying() {
+  return replayNext < replay.size();
+}
+
+const uint8_t *host_replay_take(int type, const uint8_t *expected, size_t len) {
+  if (!replaying() || rxRead == 0) return nullptr;  //Before the 'T' nothing was recorded
+  const Replayed &record = replay[replayNext];
+  if (record.type != type || memcmp(record.payload, expected, len) != 0) {
+    fprintf(stderr, "[REPLAY] Diverged at t = %lu us: recorded %s", hostUs, TRACE_NAMES[record.type]);
+    for (int x = 0; x < TRACE_PAYLOAD[record.type]; x++) fprintf(stderr, " %02X", record.payload[x]);
+    fprintf(stderr, ", the firmware did %s", TRACE_NAMES[type]);
+    for (size_t x = 0; x < len; x++) fprintf(stderr, " %02X", expected[x]);
+    fprintf(stderr, "\n");
+    exit(1);
+  }
+  replayNext++;
+  return record.payload;
+}
+
+void host_serial_script(const std::string &input, unsigned long gapUs) {
+  rxData = input;
+  rxRead = 0;
+  rxGapUs = gapUs;
+}
+
+void host_serial_fd(int fd, void (*closed)()) {
+  serialFd = fd;
+  serialClosed = closed;
+}
+
+void host_serial_send(const std::string &input) {
+  rxData += input;
+}
+
+void host_serial_output(void (*out)(uint8_t c)) {
+  serialOut = out;
+}
+
+bool host_serial_idle() {
+  return serialFd < 0 && rxRead == rxData.size() && !replaying();
+}
+
+static size_t rx_arrived() {
+  if (serialFd >= 0) {
+    char buffer[256];
+    ssize_t n = ::read(serialFd, buffer, sizeof(buffer));
+    if (n > 0) rxData.append(buffer, n);
+    if (n < 0 && errno == EIO) serialClosed();  //The other end has closed the port
+    return rxData.size();
+  }
+  if (rxGapUs == 0) return rxData.size();
+  size_t arrived = hostUs / rxGapUs + 1;
+  return arrived < rxData.size() ? arrived : rxData.size();
+}
+
+int HardwareSerial::available() {
+  if (replaying() && replay[replayNext].type == TRACE_SERIAL_RX && hostUs >= replay[replayNext].at) {
+    size_t arrived = replay[replayNext++].payload[0];
+    rxData.append(replayInput, replayInputAt, arrived);
+    replayInputAt += arrived;
+  }
+  int n = rx_arrived() - rxRead;
+  if (n == 0) host_advance(1);          //Polling takes time too, or a busy-wait for input would never end
+  return n;
+}
+
+int HardwareSerial::read() {
+  if (rxRead == rx_arrived()) return -1;
+  uint8_t c = rxData[rxRead++];
+  if (rxRead > 1) host_replay_take(TRACE_SERIAL_IN, &c, 1);  //Not the 'T'
+  return c;
+}
+
+int HardwareSerial::peek() {
+  if (rxRead == rx_arrived()) return -1;
+  return (uint8_t)rxData[rxRead];
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+  if (serialOut) {
+    serialOut(c);
+    return 1;
+  }
+  if (serialFd < 0) return fwrite(&c, 1, 1, stdout);
+  while (::write(serialFd, &c, 1) < 0) {
+    if (errno != EAGAIN) serialClosed();
+    usleep(1000);
+  }
+  return 1;
+}
+
+void host_eeprom_write(int address, uint8_t value) {
+  uint8_t written[3] = {(uint8_t)(address & 0xFF), (uint8_t)(address >> 8), value};
+  host_replay_take(TRACE_EEPROM_WRITE, written, 3);
+  hostEeprom[address & E2END] = value;
+}
+
+/* Pins. Nothing pulls the lines low on their own: the buttons & the slot selector aren't pressed, the bus idles high. */
+void host_begin() {
+  memset(hostEeprom, 0xFF, sizeof(hostEeprom));
+  memset((void *)hostPin, 0xFF, sizeof(hostPin));
+  memset((void *)hostDdr, 0, sizeof(hostDdr));
+  memset((void *)hostPort, 0, sizeof(hostPort));
+  memset(hostRam + 0x300, 0xC5, sizeof(hostRam) - 0x300); //What the firmware's paint_stack() does at boot
+  hostUs = 0;
+}
+
+void __attribute__((weak)) host_line_changed(uint8_t pin, bool low) {}
+
+static bool pulls_low(uint8_t port, uint8_t mask) {
+  return (hostDdr[port] & mask) && !(hostPort[port] & mask);
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  uint8_t port = digitalPinToPort(pin), mask = digitalPinToBitMask(pin);
+  bool wasLow = pulls_low(port, mask);
+  if (mode == OUTPUT) {
+    hostDdr[port] |= mask;
+  } else {
+    hostDdr[port] &= ~mask;
+    if (mode == INPUT_PULLUP) hostPort[port] |= mask;
+  }
+  if (pulls_low(port, mask) != wasLow) host_line_changed(pin, !wasLow);
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  uint8_t port = digitalPinToPort(pin), mask = digitalPinToBitMask(pin);
+  bool wasLow = pulls_low(port, mask);
+  if (value) {
+    hostPort[port] |= mask;
+  } else {
+    hostPort[port] &= ~mask;
+  }
+  if (pulls_low(port, mask) != wasLow) host_line_changed(pin, !wasLow);
+}
+
+int digitalRead(uint8_t pin) {
+  uint8_t port = digitalPinToPort(pin), mask = digitalPinToBitMask(pin);
+  if (pulls_low(port, mask)) return LOW;
+  return (hostPin[port] & mask) ? HIGH : LOW;
+}
+
+/* The CRCs of the OneWire library, the bus routines are in host_bus.cpp / onewire_master.cpp */
+uint8_t OneWire::crc8(const uint8_t *addr, uint8_t len) {
+  uint8_t crc = 0;
+  while (len--) {
+    uint8_t in = *addr++;
+    for (int i = 0; i < 8; i++) {
+      uint8_t mix = (crc ^ in) & 1;
+      crc >>= 1;
+      if (mix) crc ^= 0x8C;
+      in >>= 1;
+    }
+  }
+  return crc;
+}
+
+uint16_t OneWire::crc16(const uint8_t *input, uint16_t len, uint16_t crc) {
+  static const uint8_t oddparity[16] = {0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0};
+  for (uint16_t i = 0; i < len; i++) {
+    uint16_t data = (input[i] ^ crc) & 0xFF;
+    crc >>= 8;
+    if (oddparity[data & 0x0F] ^ oddparity[data >> 4]) crc ^= 0xC001;
+    data <<= 6;
+    crc ^= data;
+    data <<= 1;
+    crc ^= data;
+  }
+  return crc;
+}
@@ -0,0 +1,37 @@
+#pragma once
+// Host build of the firmware: simulated time, serial port, EEPROM & pins (host.cpp), the fobs on the 1-Wire contacts (host_bus.cpp)
+// or a 1-Wire master wired to them (wire.cpp), driven by host_main.cpp & the tests
+#include <Arduino.h>
+
+#include <string>
+
+extern unsigned long hostUs;            //Host time, moved on by the delays, the bus operations, sleep & polling
+extern uint8_t hostEeprom[E2END + 1];
+extern void (*hostAdvance)(unsigned long us); //Moves the host time on in place of host.cpp, e.g. to run the pin change interrupt alongside (wire.cpp)
+
+void host_begin();                      //Erased EEPROM, released pins, time 0
+void host_pace(unsigned speed);         //Host time runs this many times the real time (for a pty), 0 = as fast as possible
+void host_line_changed(uint8_t pin, bool low);  //A pin starts / stops pulling its line low (host_bus.cpp decodes the programming pulses)
+
+void host_serial_script(const std::string &input, unsigned long gapUs);  //Serial input, Byte n arrives at n * gapUs
+void host_serial_fd(int fd, void (*closed)());  //Serial port on a file descriptor (a pty master), both ways. closed() doesn't return.
+bool host_serial_idle();                //TRUE once the whole input script (or replayed trace) has been read
+void host_serial_send(const std::string &input);  //More input after the script, right away with a gap of 0 (the default)
+void host_serial_output(void (*out)(uint8_t c));  //The firmware's serial output goes to out() instead of stdout
+bool host_replay(const std::string &trace, std::string &error); //Serial input & 1-Wire bus from a trace, see host.cpp
+
+enum {                                  //TRACE_* of the firmware
+  TRACE_START = 0x01, TRACE_SERIAL_IN, TRACE_BUS_RESET, TRACE_BUS_WRITE, TRACE_BUS_READ, TRACE_BUS_WRITE_BIT, TRACE_BUS_READ_BIT,
+  TRACE_BUS_SEARCH, TRACE_PULSES, TRACE_EEPROM_WRITE, TRACE_LOST, TRACE_STOP, TRACE_SERIAL_RX
+};
+const uint8_t *host_replay_take(int type, const uint8_t *expected, size_t len); //The payload of the next replayed record, NULL if not replaying.
+                                                                                //It has to be this type & start with these Bytes.
+
+#define HOST_BLANK_PIN 10               //IBUTTON of the firmware
+bool host_add_blank(const char *hex, bool writable, uint8_t pin = HOST_BLANK_PIN); //Next fob to be presented on the pin's contacts,
+                                                                                  //16 hex digits
+bool host_blank_rom(uint8_t pin, size_t index, uint8_t rom[8]);  //The ROM the index-th fob of the pin has now (after the writes)
+bool host_search_glitch(unsigned search, const char *hex, uint8_t pin = HOST_BLANK_PIN); //The search-th Search ROM that finds a
+                                                                                           //fob from now on (1 = the next one)
+                                                                                           //reads this ROM instead of the fob's
+void host_blank_timing(unsigned long holdMs, unsigned long awayMs);
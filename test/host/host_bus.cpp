@@ -0,0 +1,195 @@
+/*
+ * Host build of the firmware - the fobs on its 1-Wire contacts, behind the OneWire interface
+ *
+ * The 1-Wire contacts on a pin (HOST_BLANK_PIN = IBUTTON, or a probe's) see a sequence of fobs, presented one after the
+ * other. A writable one (RW1990) takes the 64 programming pulses that follow a Write ROM (0xD5 / 0xC5), as long as the bus
+ * isn't reset in between; a '1' is a pulse of 30 us or more. A fob is taken off the contacts holdMs after it was written,
+ * and the next one comes awayMs later. A pin without fobs has nothing on its contacts.
+ * The bus operations take their standard speed time. While a trace is replayed, their results are the recorded ones.
+ */
+#include "host.h"
+
+#include <OneWire.h>
+
+#include <map>
+#include <vector>
+
+struct Blank {
+  uint8_t rom[8];
+  bool writable;
+};
+struct Contacts {                       //One pin's
+  std::vector<Blank> blanks;
+  size_t blankIndex = 0;                //The one on the contacts, or the next to come
+  unsigned long blankFrom = 0;          //hostUs it's presented at
+  unsigned long blankTakenAt = 0;       //hostUs it's taken off at, 0 = not written yet
+  bool programming = false;             //Write ROM received, counting the pulses
+  uint8_t programmed[8];
+  uint8_t pulses;
+  unsigned long pulseFrom;
+  bool pulsing = false;
+  unsigned long searches = 0;
+  std::map<unsigned long, Blank> glitches;  //Searches that read something else than the fob, by their number
+};
+static std::map<uint8_t, Contacts> contacts;
+static unsigned long blankHoldUs = 2000000, blankAwayUs = 3000000;
+
+static bool parse_rom(const char *hex, uint8_t rom[8]) {
+  if (strlen(hex) != 16) return false;
+  for (int x = 0; x < 8; x++) {
+    char digits[3] = {hex[2 * x], hex[2 * x + 1], 0};
+    char *end;
+    rom[x] = strtoul(digits, &end, 16);
+    if (*end) return false;
+  }
+  return true;
+}
+
+bool host_add_blank(const char *hex, bool writable, uint8_t pin) {
+  Blank blank;
+  blank.writable = writable;
+  if (!parse_rom(hex, blank.rom)) return false;
+  contacts[pin].blanks.push_back(blank);
+  return true;
+}
+
+bool host_search_glitch(unsigned search, const char *hex, uint8_t pin) {
+  Contacts &c = contacts[pin];
+  Blank glitch;
+  if (search == 0 || !parse_rom(hex, glitch.rom)) return false;
+  c.glitches[c.searches + search] = glitch;
+  return true;
+}
+
+bool host_blank_rom(uint8_t pin, size_t index, uint8_t rom[8]) {
+  auto found = contacts.find(pin);
+  if (found == contacts.end() || index >= found->second.blanks.size()) return false;
+  memcpy(rom, found->second.blanks[index].rom, 8);
+  return true;
+}
+
+void host_blank_timing(unsigned long holdMs, unsigned long awayMs) {
+  blankHoldUs = holdMs * 1000;
+  blankAwayUs = awayMs * 1000;
+}
+
+static Contacts *contacts_of(uint8_t pin) { //NULL if no fob ever comes to the pin
+  auto found = contacts.find(pin);
+  return found == contacts.end() ? 0 : &found->second;
+}
+
+static Blank *blank_present(Contacts *c) {
+  if (!c) return 0;
+  while (c->blankIndex < c->blanks.size()) {
+    if (c->blankTakenAt == 0 || hostUs < c->blankTakenAt) return hostUs >= c->blankFrom ? &c->blanks[c->blankIndex] : 0;
+    c->blankIndex++;
+    c->blankFrom = c->blankTakenAt + blankAwayUs;
+    c->blankTakenAt = 0;
+  }
+  return 0;
+}
+
+static void blank_pulse(Contacts *c, unsigned long us) { //The end of a programming pulse
+  if (!c->programming || c->pulses >= 64) return;
+  if (us >= 30) c->programmed[c->pulses >> 3] |= 1 << (c->pulses & 7);
+  c->pulses++;
+}
+
+static void blank_reset(Contacts *c) {  //Ends a Write ROM
+  if (!c || !c->programming) return;
+  c->programming = false;
+  Blank *blank = blank_present(c);
+  if (!blank || c->pulses < 64) return;
+  if (blank->writable) memcpy(blank->rom, c->programmed, 8);
+  c->blankTakenAt = hostUs + blankHoldUs;
+}
+
+void host_line_changed(uint8_t pin, bool low) {
+  Contacts *c = contacts_of(pin);
+  if (!c) return;
+  if (low) {
+    c->pulsing = true;
+    c->pulseFrom = hostUs;
+  } else if (c->pulsing) {
+    c->pulsing = false;
+    blank_pulse(c, hostUs - c->pulseFrom);
+  }
+}
+
+/* The bus, standard speed time slots */
+#define SLOT_US 70
+#define RESET_US 960
+
+OneWire::OneWire(uint8_t pin) : pin(pin), searched(false) {}
+
+uint8_t OneWire::reset(void) {
+  delayMicroseconds(RESET_US);
+  if (const uint8_t *recorded = host_replay_take(TRACE_BUS_RESET, &pin, 1)) return recorded[1];
+  Contacts *c = contacts_of(pin);
+  blank_reset(c);
+  return blank_present(c) != 0;
+}
+
+void OneWire::select(const uint8_t rom[8]) {
+  write(0x55);
+  for (int x = 0; x < 8; x++) write(rom[x]);
+}
+
+void OneWire::skip(void) {
+  write(0xCC);
+}
+
+void OneWire::depower(void) {}
+
+void OneWire::write(uint8_t v, uint8_t power) {
+  delayMicroseconds(8 * SLOT_US);
+  uint8_t written[2] = {pin, v};
+  if (host_replay_take(TRACE_BUS_WRITE, written, 2)) return;
+  Contacts *c = contacts_of(pin);
+  if (!blank_present(c)) return;
+  if (v == 0xD5 || v == 0xC5) {         //Write ROM of the RW1990 / TM01C style blanks, the bits follow as pulses
+    c->programming = true;
+    c->pulses = 0;
+    memset(c->programmed, 0, sizeof(c->programmed));
+  }
+}
+
+uint8_t OneWire::read(void) {
+  delayMicroseconds(8 * SLOT_US);
+  if (const uint8_t *recorded = host_replay_take(TRACE_BUS_READ, &pin, 1)) return recorded[1];
+  return 0xFF;
+}
+
+void OneWire::write_bit(uint8_t v) {
+  delayMicroseconds(SLOT_US);
+  uint8_t written[2] = {pin, v};
+  host_replay_take(TRACE_BUS_WRITE_BIT, written, 2);
+}
+
+uint8_t OneWire::read_bit(void) {
+  delayMicroseconds(SLOT_US);
+  if (const uint8_t *recorded = host_replay_take(TRACE_BUS_READ_BIT, &pin, 1)) return recorded[1];
+  return 1;
+}
+
+void OneWire::reset_search() {
+  searched = false;
+}
+
+bool OneWire::search(uint8_t *newAddr, bool search_mode) {
+  if (const uint8_t *recorded = host_replay_take(TRACE_BUS_SEARCH, &pin, 1)) {
+    delayMicroseconds(RESET_US);        //The same time as below
+    if (!recorded[1]) return false;
+    delayMicroseconds(8 * SLOT_US + 64 * 3 * SLOT_US);
+    memcpy(newAddr, recorded + 2, 8);
+    return true;
+  }
+  Contacts *c = contacts_of(pin);
+  Blank *blank = reset() ? blank_present(c) : 0;
+  if (!blank || searched) return false;
+  delayMicroseconds(8 * SLOT_US + 64 * 3 * SLOT_US);
+  auto glitch = c->glitches.find(++c->searches);
+  memcpy(newAddr, glitch != c->glitches.end() ? glitch->second.rom : blank->rom, 8);
+  searched = true;
+  return true;
+}
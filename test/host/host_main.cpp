@@ -0,0 +1,205 @@
+/*
+ * host_firmware - the firmware (src/main.cpp) running on the host, see host.cpp
+ *
+ * Usage:
+ *   host_firmware [options]                       serial input from stdin, output to stdout
+ *   host_firmware [options] --pty [-- command...] serial port on a pty, "{}" in the command is its path
+ *   host_firmware [options] --replay <trace>      the session of a trace ('T') again, output to stdout
+ *
+ * Options:
+ *   --blank <16 hex digits>[,ro]  next fob presented on the contacts, "ro" ones can't be written (repeatable)
+ *   --hold <ms> --away <ms>       a written fob is taken off after hold ms, the next one comes away ms later
+ *   --eeprom <file>               EEPROM image, loaded if it exists & saved at the end
+ *   --gap <us>                    stdin input: one Byte arrives every gap us (default 2000, ~5000 Bd)
+ *   --loops <n>                   stdin input: loop() runs this many times after the input is read (default 2000)
+ *   --speed <n>                   pty: the simulated time runs n times the real time (default 1)
+ *   --loops <n> applies to a replay too. A replay exits with 1 where the firmware does something else than recorded.
+ *
+ * With a command, the pty is opened by it: the firmware boots once the command has set the port up (raw mode),
+ * like a board that resets when its port is opened, and the exit status is the command's.
+ */
+#include "host.h"
+
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const char *eeprom = nullptr;
+static const char *trace = nullptr;
+static pid_t child = 0;
+
+static void usage() {
+  fprintf(stderr,
+    "Usage: host_firmware [--blank <hex>[,ro]]... [--hold <ms>] [--away <ms>] [--eeprom <file>]\n"
+    "                     [--gap <us>] [--loops <n>] [--speed <n>] [--pty [-- command...] | --replay <trace>]\n");
+}
+
+static void read_all(FILE *file, std::string &data) {
+  char buffer[4096];
+  size_t n;
+  while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) data.append(buffer, n);
+}
+
+static int open_pty(std::string &path) {
+  int fd = posix_openpt(O_RDWR | O_NOCTTY);
+  if (fd < 0 || grantpt(fd) != 0 || unlockpt(fd) != 0) {
+    perror("posix_openpt");
+    return -1;
+  }
+  path = ptsname(fd);
+  fcntl(fd, F_SETFL, O_NONBLOCK);
+  return fd;
+}
+
+static bool port_opened(int fd) {       //The other end switched the port to raw mode
+  termios tio;
+  return tcgetattr(fd, &tio) == 0 && !(tio.c_lflag & ICANON);
+}
+
+static pid_t spawn(std::vector<std::string> command, const std::string &path) {
+  std::vector<char *> argv;
+  for (std::string &arg : command) {
+    if (arg == "{}") arg = path;
+    argv.push_back(&arg[0]);
+  }
+  argv.push_back(nullptr);
+  pid_t pid = fork();
+  if (pid == 0) {
+    execvp(argv[0], argv.data());
+    perror(argv[0]);
+    _exit(127);
+  }
+  return pid;
+}
+
+static void finish(int status) {
+  if (eeprom) {
+    FILE *file = fopen(eeprom, "wb");
+    if (!file || fwrite(hostEeprom, 1, sizeof(hostEeprom), file) != sizeof(hostEeprom)) {
+      perror(eeprom);
+      status = 1;
+    }
+    if (file) fclose(file);
+  }
+  fflush(stdout);
+  exit(status);
+}
+
+static void port_closed() {             //The firmware may be waiting for input anywhere, this is where the run ends
+  int status = 1;
+  if (child) waitpid(child, &status, 0);
+  finish(child && WIFEXITED(status) ? WEXITSTATUS(status) : 1);
+}
+
+int main(int argc, char **argv) {
+  host_begin();
+  unsigned long gapUs = 2000, loops = 2000, holdMs = 2000, awayMs = 3000;
+  unsigned speed = 1;
+  bool pty = false;
+  std::vector<std::string> command;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--") {
+      command.assign(argv + i + 1, argv + argc);
+      break;
+    }
+    if (arg == "--pty") {
+      pty = true;
+      continue;
+    }
+    if (i + 1 == argc) {
+      usage();
+      return 2;
+    }
+    const char *value = argv[++i];
+    if (arg == "--blank") {
+      std::string spec = value;
+      bool readOnly = spec.size() > 16 && spec.substr(16) == ",ro";
+      if (!host_add_blank(spec.substr(0, 16).c_str(), !readOnly)) {
+        fprintf(stderr, "host_firmware: bad fob ID: %s\n", value);
+        return 2;
+      }
+    } else if (arg == "--hold") {
+      holdMs = strtoul(value, nullptr, 10);
+    } else if (arg == "--away") {
+      awayMs = strtoul(value, nullptr, 10);
+    } else if (arg == "--eeprom") {
+      eeprom = value;
+    } else if (arg == "--gap") {
+      gapUs = strtoul(value, nullptr, 10);
+    } else if (arg == "--loops") {
+      loops = strtoul(value, nullptr, 10);
+    } else if (arg == "--speed") {
+      speed = strtoul(value, nullptr, 10);
+    } else if (arg == "--replay") {
+      trace = value;
+    } else {
+      usage();
+      return 2;
+    }
+  }
+  if ((!command.empty() && !pty) || (pty && trace)) {
+    usage();
+    return 2;
+  }
+  host_blank_timing(holdMs, awayMs);
+
+  if (eeprom) {
+    std::string image;
+    FILE *file = fopen(eeprom, "rb");
+    if (file) {
+      read_all(file, image);
+      fclose(file);
+    }
+    memcpy(hostEeprom, image.data(), image.size() < sizeof(hostEeprom) ? image.size() : sizeof(hostEeprom));
+  }
+
+  if (pty) {
+    std::string path;
+    int fd = open_pty(path);
+    if (fd < 0) return 1;
+    if (!command.empty()) child = spawn(command, path);
+    if (child < 0) return 1;
+    if (!child) fprintf(stderr, "%s\n", path.c_str());
+    while (!port_opened(fd)) {
+      int status;
+      if (child && waitpid(child, &status, WNOHANG) == child) return WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50)); //Let the other end flush the port first
+    host_serial_fd(fd, port_closed);
+    host_pace(speed ? speed : 1);
+    setup();
+    while (true) loop();
+  }
+
+  if (trace) {
+    std::string recorded, error;
+    FILE *file = fopen(trace, "rb");
+    if (!file) {
+      perror(trace);
+      return 1;
+    }
+    read_all(file, recorded);
+    fclose(file);
+    if (!host_replay(recorded, error)) {
+      fprintf(stderr, "host_firmware: can't replay %s: %s\n", trace, error.c_str());
+      return 1;
+    }
+  } else {
+    std::string input;
+    read_all(stdin, input);
+    host_serial_script(input, gapUs);
+  }
+  setup();
+  while (!host_serial_idle()) loop();
+  for (unsigned long i = 0; i < loops; i++) loop();
+  finish(0);
+}
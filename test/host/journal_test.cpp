@@ -0,0 +1,112 @@
+/*
+ * journal_test - the audit journal of src/main.cpp: the 32 entry ring in the EEPROM, its CSV export & its recovery after a reset
+ *
+ * More appends than the ring holds, trickled to the EEPROM a Byte per journal_service(). The export has to list the newest 32,
+ * oldest first. After a power cut in the middle of an entry (and a corrupted older one) the CRC has to drop both from the
+ * export, and journal_init() has to continue the ring right after the newest intact entry.
+ */
+#include "host.h"
+#include "test.h"
+
+#include <vector>
+
+#define JOURNAL_ENTRIES 32              //Of the firmware
+#define JOURNAL_QUEUE 4
+#define JOURNAL_READ 0
+#define SLOT 2
+#define APPENDS 40                      //Seq 0-39, entry x holds seq x + 32 for x < 8, seq x after that
+#define CORRUPTED 36                    //An older entry, in entry 4: before the torn one in the EEPROM
+
+void journal_init();
+void journal_append(byte op, byte slot, bool ok, const byte id[8]);
+void journal_service();
+void print_journal();
+unsigned int journal_addr(byte entry);
+extern byte journalQueued, journalQueueHead, journalByte, journalNext, journalSeq;
+extern bool journalBooted;
+
+static const uint8_t code[8] = {0x01, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x75};
+
+struct Entry {
+  int seq, boot;
+  unsigned long dt;
+  char op[8], slot[4], result[8], hash[8], id[20];
+};
+static std::vector<Entry> entries;
+static int exported = -1;
+
+static void csv_line(const std::string &line) {
+  Entry e = {};
+  if (sscanf(line.c_str(), "[DONE] Entries: %d", &exported) == 1) return;
+  if (sscanf(line.c_str(), "%d,%d,%lu,%7[^,],%3[^,],%7[^,],%7[^,],%19s", &e.seq, &e.boot, &e.dt, e.op, e.slot, e.result,
+             e.hash, e.id) >= 7) {
+    entries.push_back(e);
+  }
+}
+
+static void export_journal() {
+  entries.clear();
+  exported = -1;
+  print_journal();
+  delay(100);                           //The rest of the output leaves the console queue meanwhile
+}
+
+static bool in_order(int first, int last, int skipped) {  //The export lists exactly these sequence numbers
+  size_t i = 0;
+  for (int seq = first; seq <= last; seq++) {
+    if (seq == skipped) continue;
+    if (i == entries.size() || entries[i++].seq != seq) return false;
+  }
+  return i == entries.size();
+}
+
+int main() {
+  host_begin();
+  memcpy(hostEeprom + (SLOT << 5), code, 8);
+  host_serial_output(console_output);
+  setup();
+  on_line = csv_line;
+
+  for (int x = 0; x < APPENDS; x++) {
+    delay(10);                          //dt 10 ms, 11 when the host time in between rounds up
+    journal_append(JOURNAL_READ, SLOT, x % 2 == 0, code);
+  }
+  CHECK(journalQueued == JOURNAL_QUEUE, "the appends beyond the RAM queue weren't written right away");
+  int services = 0;
+  for (; journalQueued > 0 && services < 1000; services++) journal_service();
+  CHECK(services == JOURNAL_QUEUE * 8, "the queued entries weren't written a Byte per journal_service()");
+
+  export_journal();
+  CHECK(exported == JOURNAL_ENTRIES && in_order(APPENDS - JOURNAL_ENTRIES, APPENDS - 1, -1),
+        "not the newest 32 entries, oldest first");
+  bool fields = !entries.empty();
+  for (const Entry &e : entries) {
+    if (e.boot != 0 || e.dt < 10 || e.dt > 11 || strcmp(e.op, "READ") != 0 || strcmp(e.slot, "2") != 0 ||
+        strcmp(e.result, e.seq % 2 == 0 ? "OK" : "FAIL") != 0 || strcmp(e.id, "0111223344556675") != 0) {
+      fields = false;
+    }
+  }
+  CHECK(fields, "an entry's fields");
+
+  journal_append(JOURNAL_READ, SLOT, true, code);    //Seq 40 into entry 8, the power fails after its first 3 Bytes
+  for (int x = 0; x < 3; x++) journal_service();
+  hostEeprom[journal_addr(CORRUPTED % JOURNAL_ENTRIES) + 5] ^= 0x04;
+  journalQueued = journalQueueHead = journalByte = 0;  //The reset
+  journalNext = journalSeq = 0;
+  journalBooted = false;
+  journal_init();
+  CHECK(journalNext == APPENDS % JOURNAL_ENTRIES && journalSeq == APPENDS,
+        "the journal doesn't continue after the newest intact entry");
+
+  export_journal();
+  CHECK(exported == JOURNAL_ENTRIES - 2 && in_order(APPENDS - JOURNAL_ENTRIES + 1, APPENDS - 1, CORRUPTED),
+        "the torn & the corrupted entry weren't skipped");
+
+  journal_append(JOURNAL_READ, SLOT, true, code);
+  export_journal();
+  CHECK(exported == JOURNAL_ENTRIES - 1 && in_order(APPENDS - JOURNAL_ENTRIES + 1, APPENDS, CORRUPTED),
+        "the first entry after the reset didn't take the torn one's place");
+  CHECK(!entries.empty() && entries.back().boot == 1, "the first entry after the reset isn't marked");
+
+  return test_result("journal_test");
+}
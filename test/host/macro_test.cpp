@@ -0,0 +1,74 @@
+/*
+ * macro_test - the command macros ('K') of src/main.cpp: recorded from the console into the EEPROM, then replayed
+ *
+ * The macro clears 2 memory slots through the advanced mode. Typed in, the same commands wait for the rest of the input
+ * before each one (Console.settle()), replayed from the EEPROM they don't: the replay has to take less than one such wait.
+ */
+#include "host.h"
+#include "test.h"
+
+#define MACRO_ADDR 0x300                //Of the firmware
+#define MACRO_TEXT 56
+#define SETTLE_MS 30                    //serial_parser()'s wait for the rest of a typed command
+#define MACRO "AM3CM5CA"                //Advanced mode, clear slots 3 & 5, advanced mode off
+#define LOOPS 2000
+
+static const uint8_t code[8] = {0x01, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x75};
+static unsigned long startUs = 0, doneUs = 0;
+static bool saved = false;
+
+static void timing(const std::string &line) {
+  if (line == "[SUCCESS] Macro saved!") saved = true;
+  if (line == "[INFO] Running macro 0") startUs = hostUs;
+  if (line == "[INFO] Active memory slot selection via serial console has been DISABLED.") doneUs = hostUs;
+}
+
+static void fill_slots() {
+  for (int slot = 3; slot <= 5; slot++) memcpy(hostEeprom + (slot << 5), code, 8);
+}
+
+static bool slots_cleared() {           //3 & 5, 4 in between kept
+  static const uint8_t cleared[16] = {};
+  return memcmp(hostEeprom + (3 << 5), cleared, 16) == 0 && memcmp(hostEeprom + (5 << 5), cleared, 16) == 0 &&
+         memcmp(hostEeprom + (4 << 5), code, 8) == 0;
+}
+
+static void run(const std::string &input) { //Until the advanced mode is off again
+  doneUs = 0;
+  host_serial_send(input);
+  for (int x = 0; x < LOOPS && doneUs == 0 && !saved; x++) loop();
+  delay(100);                           //The rest of the output leaves the console queue meanwhile
+}
+
+int main() {
+  host_begin();
+  host_serial_output(console_output);
+  setup();
+  on_line = timing;
+
+  run("KR0\nCLEAR35\n" MACRO "\n");
+  CHECK(saved, "the macro wasn't saved");
+  CHECK(memcmp(hostEeprom + MACRO_ADDR, "CLEAR35", 8) == 0, "the macro's name, 0x00 padded");
+  CHECK(memcmp(hostEeprom + MACRO_ADDR + 8, MACRO, sizeof(MACRO)) == 0, "the macro's text, 0x00 terminated");
+  CHECK(doneUs == 0, "the recorded commands ran");
+  saved = false;
+
+  fill_slots();
+  startUs = hostUs;
+  run(MACRO);
+  unsigned long typedUs = doneUs - startUs;
+  CHECK(doneUs != 0 && slots_cleared(), "the typed commands didn't clear the slots");
+
+  fill_slots();
+  output.clear();
+  run("K0");
+  unsigned long replayUs = doneUs - startUs;
+  CHECK(output.find("CLEAR35  : " MACRO) != std::string::npos, "the macro isn't listed by its name");
+  CHECK(doneUs != 0 && slots_cleared(), "the replayed macro didn't clear the slots");
+  CHECK(output.find("[ERROR]") == std::string::npos, "an error while replaying");
+  printf("Typed: %lu us, replayed: %lu us\n", typedUs, replayUs);
+  CHECK(typedUs >= 6 * SETTLE_MS * 1000UL, "the typed commands didn't wait for the rest of the input");
+  CHECK(replayUs < SETTLE_MS * 1000UL, "the replay waited for input it already had");
+
+  return test_result("macro_test");
+}
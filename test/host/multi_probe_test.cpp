@@ -0,0 +1,63 @@
+/*
+ * multi_probe_test - the multi-probe clone ('N') of src/main.cpp, with fobs on the contacts of all three probes
+ *
+ * The blanks present together are written in one batch, their programming pulses interleaved so they share the
+ * recovery time: the batch of three has to take about as long as the batch of one that follows it, not three times.
+ */
+#include "host.h"
+#include "test.h"
+
+void multi_probe_clone();
+
+#define PROBE_1_PIN 16                  //PROBE_PINS of the firmware: IBUTTON (HOST_BLANK_PIN), 16, 14
+#define PROBE_2_PIN 14
+#define SLOT_F 0x1E0                    //The idle selector picks slot F
+
+static const uint8_t code[8] = {0x01, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x75};
+static int batches = 0;
+static unsigned long batchMs[2];
+static int batchSize[2];
+
+static void until_second_batch(const std::string &line) {
+  int size;
+  unsigned long ms;
+  if (sscanf(line.c_str(), "[INFO] Batch of %d written in %lu ms", &size, &ms) != 2) return;
+  if (batches < 2) {
+    batchSize[batches] = size;
+    batchMs[batches] = ms;
+  }
+  if (++batches == 2) host_serial_send("X");
+}
+
+static bool written(uint8_t pin, size_t index) {
+  uint8_t rom[8];
+  return host_blank_rom(pin, index, rom) && memcmp(rom, code, 8) == 0;
+}
+
+int main() {
+  host_begin();
+  memcpy(hostEeprom + SLOT_F, code, 8);
+  host_add_blank("01FFFFFFFFFFFF2F", true);    //Probe 0: one now, one once it has been taken off
+  host_add_blank("01FFFFFFFFFFFF2F", true);
+  host_add_blank("01FFFFFFFFFFFF2F", true, PROBE_1_PIN);
+  host_add_blank("01FFFFFFFFFFFF2F", true, PROBE_2_PIN);
+  host_blank_timing(500, 500);
+  host_serial_output(console_output);
+  setup();
+
+  on_line = until_second_batch;
+  output.clear();
+  multi_probe_clone();
+  delay(100);                           //The rest of the output leaves the console queue meanwhile
+
+  CHECK(batches == 2 && batchSize[0] == 3 && batchSize[1] == 1, "not a batch of 3, then a batch of 1");
+  CHECK(written(HOST_BLANK_PIN, 0) && written(PROBE_1_PIN, 0) && written(PROBE_2_PIN, 0), "a blank of the first batch wasn't written");
+  CHECK(written(HOST_BLANK_PIN, 1), "the blank of the second batch wasn't written");
+  CHECK(output.find("[PROBE 0] OK") != std::string::npos && output.find("[PROBE 1] OK") != std::string::npos &&
+        output.find("[PROBE 2] OK") != std::string::npos, "a probe didn't verify OK");
+  CHECK(output.find("ERROR") == std::string::npos, "an error reported");
+  printf("Batch of 3: %lu ms, batch of 1: %lu ms\n", batchMs[0], batchMs[1]);
+  CHECK(batchMs[0] * 2 < batchMs[1] * 3, "the batch of 3 took 1.5 times the batch of 1 or more, the writes weren't interleaved");
+
+  return test_result("multi_probe_test");
+}
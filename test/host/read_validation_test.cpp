@@ -0,0 +1,79 @@
+/*
+ * read_validation_test - the table driven CRC8 & the multi-sample read validation (search_iButton()) of src/main.cpp
+ *
+ * The table has to give the bitwise CRC8 for every Byte. The reads get samples that differ from the fob (host_search_glitch()):
+ * a read is done as soon as two consecutive samples agree, falls back to a majority vote of READ_SAMPLES, and fails without one.
+ */
+#include "host.h"
+#include "test.h"
+
+byte crc8(const byte data[], byte len);
+bool search_iButton(byte dest[8], byte slot);
+extern byte readSamples;
+
+#define READ_SAMPLES 5                  //Of the firmware
+#define NO_SLOT 0xFF
+
+static const char *const A = "01A1B2C3D4E5F68F", *const B = "0111223344556675", *const C = "01AABBCCDDEEFF2F";
+static const char *const A_BAD_CRC = "01A1B2C3D4E5F68E";
+
+static uint8_t crc8_bitwise(const uint8_t *data, uint8_t len) { //Dallas / Maxim, x^8 + x^5 + x^4 + 1, LSB first
+  uint8_t crc = 0;
+  while (len--) {
+    crc ^= *data++;
+    for (int bit = 0; bit < 8; bit++) crc = (crc & 1) ? (crc >> 1) ^ 0x8C : crc >> 1;
+  }
+  return crc;
+}
+
+static std::string hex(const byte rom[8]) {
+  char text[17];
+  for (int x = 0; x < 8; x++) snprintf(text + 2 * x, 3, "%02X", rom[x]);
+  return text;
+}
+
+static void glitches(const char *const samples[], int n) { //What the next n samples read, NULL = the fob's own ROM
+  for (int x = 0; x < n; x++) {
+    if (samples[x]) host_search_glitch(x + 1, samples[x]);
+  }
+}
+
+int main() {
+  bool tableOk = true;
+  for (int x = 0; x < 256; x++) {
+    byte b = x;
+    if (crc8(&b, 1) != crc8_bitwise(&b, 1)) tableOk = false;
+  }
+  CHECK(tableOk, "the CRC8 table differs from the bitwise CRC8");
+  const byte rom[7] = {0x01, 0xA1, 0xB2, 0xC3, 0xD4, 0xE5, 0xF6};
+  CHECK(crc8(rom, 7) == 0x8F && crc8_bitwise(rom, 7) == 0x8F, "wrong CRC8 of a ROM");
+
+  host_begin();
+  host_serial_output(console_output);   //Quiet
+  setup();
+  byte got[8];
+
+  CHECK(!search_iButton(got, NO_SLOT) && readSamples == 1, "an empty contact wasn't given up on after the first sample");
+
+  host_add_blank(A, false);
+  CHECK(search_iButton(got, NO_SLOT) && hex(got) == A && readSamples == 2, "a clean read took more than 2 samples");
+
+  const char *const badCrcFirst[] = {A_BAD_CRC};
+  glitches(badCrcFirst, 1);
+  CHECK(search_iButton(got, NO_SLOT) && hex(got) == A && readSamples == 3, "a sample with a bad CRC wasn't skipped");
+
+  const char *const oneWrong[] = {nullptr, B};       //A valid CRC, but another ROM: A B A A
+  glitches(oneWrong, 2);
+  CHECK(search_iButton(got, NO_SLOT) && hex(got) == A && readSamples == 4,
+        "one wrong sample: not done at the first two consecutive agreeing ones");
+
+  const char *const majority[] = {nullptr, B, nullptr, C, nullptr};  //A B A C A, never two in a row
+  glitches(majority, READ_SAMPLES);
+  CHECK(search_iButton(got, NO_SLOT) && hex(got) == A && readSamples == READ_SAMPLES, "the majority vote didn't pick A");
+
+  const char *const tie[] = {nullptr, B, C, nullptr, B};    //A B C A B, 2 : 2 : 1
+  glitches(tie, READ_SAMPLES);
+  CHECK(!search_iButton(got, NO_SLOT), "a read without a majority succeeded");
+
+  return test_result("read_validation_test");
+}
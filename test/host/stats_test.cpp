@@ -0,0 +1,91 @@
+/*
+ * stats_test - the batched operation statistics of src/main.cpp
+ *
+ * The counter updates collect in RAM, merged per counter, and reach the EEPROM only when stats_service() finds the batch
+ * half full or old, or when it's full. A new family code's entry is claimed in the batch too. The counters saturate.
+ */
+#include "host.h"
+#include "test.h"
+
+#define STATS_READS 0                   //Of the firmware
+#define STATS_WRITES 1
+#define STATS_VERIFY_FAILS 2
+#define STATS_FLUSH_MS 30000UL
+#define STATS_BATCH 12
+#define TOTAL_READS 0x202               //StatsBlock at 0x200: magic, then the 32 bit totals
+#define TOTAL_VERIFY_FAILS 0x20A
+#define TOTAL_BRICK_SUSPECTS 0x212
+#define OP_READS 0                      //OpStats
+#define OP_WRITES 2
+#define OP_VERIFY_FAILS 4
+#define OP_BRICK_SUSPECTS 6
+#define OP_WRITE_MS_SUM 7
+
+void stats_count(byte counter, byte slot, byte family, unsigned int n);
+void stats_write(byte slot, byte family, unsigned long ms, bool present);
+void stats_service();
+void stats_flush();
+unsigned int stats_slot_addr(byte slot);
+unsigned int stats_family_addr(byte family);
+extern byte statsPending;
+
+static uint32_t counter(unsigned int addr, int size) {  //Straight from the EEPROM, little endian
+  uint32_t value = 0;
+  for (int x = size - 1; x >= 0; x--) value = (value << 8) | hostEeprom[addr + x];
+  return value;
+}
+
+int main() {
+  host_begin();
+  host_serial_output(console_output);   //Quiet
+  setup();
+  stats_flush();
+  uint8_t before[E2END + 1];
+  memcpy(before, hostEeprom, sizeof(before));
+
+  for (int x = 0; x < 5; x++) stats_count(STATS_READS, 3, 0x01, 1);
+  CHECK(statsPending == 4, "repeated reads didn't merge to the total, slot & family updates plus the family claim");
+  stats_count(STATS_READS, 3, 0x0C, 1);
+  unsigned int family01 = stats_family_addr(0x01), family0C = stats_family_addr(0x0C);
+  CHECK(family01 != family0C, "two new family codes claimed the same entry");
+  CHECK(memcmp(before, hostEeprom, sizeof(before)) == 0, "the EEPROM was written before the batch was flushed");
+  CHECK(statsPending == STATS_BATCH / 2, "the second family code didn't add its claim & counter");
+  stats_service();
+  CHECK(statsPending == 0, "a half full batch wasn't flushed");
+  CHECK(counter(TOTAL_READS, 4) == 6, "total reads");
+  CHECK(counter(stats_slot_addr(3) + OP_READS, 2) == 6, "slot reads");
+  CHECK(hostEeprom[family01 - 1] == 0x01 && hostEeprom[family0C - 1] == 0x0C, "the family claims didn't reach the EEPROM");
+  CHECK(counter(family01 + OP_READS, 2) == 5 && counter(family0C + OP_READS, 2) == 1, "family reads");
+
+  stats_write(3, 0x01, 800, false);
+  stats_flush();
+  CHECK(counter(stats_slot_addr(3) + OP_WRITES, 2) == 1 && counter(family01 + OP_WRITES, 2) == 1, "writes");
+  CHECK(counter(stats_slot_addr(3) + OP_WRITE_MS_SUM, 3) == 800, "write latency sum");
+  CHECK(counter(TOTAL_BRICK_SUSPECTS, 4) == 1 && counter(stats_slot_addr(3) + OP_BRICK_SUSPECTS, 1) == 1 &&
+        counter(family01 + OP_BRICK_SUSPECTS, 1) == 1, "suspected bricked blank");
+
+  stats_count(STATS_VERIFY_FAILS, 3, 0x01, 300);
+  stats_service();
+  CHECK(statsPending > 0, "a fresh batch of a few updates was flushed");
+  delay(STATS_FLUSH_MS);
+  stats_service();
+  CHECK(statsPending == 0, "an old batch wasn't flushed");
+  CHECK(counter(TOTAL_VERIFY_FAILS, 4) == 300, "a 32 bit total didn't take 300");
+  CHECK(counter(stats_slot_addr(3) + OP_VERIFY_FAILS, 1) == 255, "a Byte counter didn't stop at 255");
+
+  bool early = false;
+  for (byte slot = 0; slot < 16; slot++) {  //The total & the family merge, every slot takes an entry of its own
+    stats_count(STATS_WRITES, slot, 0x01, 1);
+    if (statsPending > STATS_BATCH) early = true;
+  }
+  CHECK(!early && statsPending < STATS_BATCH, "a full batch wasn't flushed");
+  stats_flush();
+  bool everySlot = true;
+  for (byte slot = 0; slot < 16; slot++) {
+    if (counter(stats_slot_addr(slot) + OP_WRITES, 2) != (slot == 3 ? 2u : 1u)) everySlot = false;
+  }
+  CHECK(everySlot, "a write was lost with the full batch");
+  CHECK(counter(family01 + OP_WRITES, 2) == 17, "family writes after the full batch");
+
+  return test_result("stats_test");
+}
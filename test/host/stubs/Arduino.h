@@ -0,0 +1,153 @@
+#pragma once
+// Host build: the part of the Arduino core the firmware uses, on an Uno pinout. Implemented in host.cpp.
+#include <ctype.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+typedef uint16_t word;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define DEC 10
+#define HEX 16
+#define BIN 2
+#define NOT_A_PIN 0
+#define NOT_AN_INTERRUPT -1
+
+#define lowByte(w) ((uint8_t)((w) & 0xFF))
+#define highByte(w) ((uint8_t)((w) >> 8))
+
+extern "C" {
+void setup(void);
+void loop(void);
+void yield(void);
+}
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+inline void noInterrupts() {}
+inline void interrupts() {}
+inline int toUpperCase(int c) { return toupper(c); }
+
+//Uno: D0-D7 port D, D8-D13 port B, A0-A5 (D14-D19) port C
+#define PB 2
+#define PC 3
+#define PD 4
+extern volatile uint8_t hostPin[5], hostDdr[5], hostPort[5];  //PINx, DDRx, PORTx, indexed by the port
+#define digitalPinToPort(p) ((p) < 8 ? PD : ((p) < 14 ? PB : PC))
+#define digitalPinToBitMask(p) ((uint8_t)(1 << ((p) < 8 ? (p) : ((p) < 14 ? (p) - 8 : (p) - 14))))
+#define portInputRegister(port) (&hostPin[port])
+#define portModeRegister(port) (&hostDdr[port])
+#define portOutputRegister(port) (&hostPort[port])
+#define digitalPinToPCICR(p) (((p) >= 0 && (p) <= 19) ? (&PCICR) : ((uint8_t *)0))
+#define digitalPinToPCICRbit(p) ((p) < 8 ? 2 : ((p) < 14 ? 0 : 1))
+#define digitalPinToPCMSK(p) ((p) < 8 ? (&PCMSK2) : ((p) < 14 ? (&PCMSK0) : (&PCMSK1)))
+#define digitalPinToPCMSKbit(p) ((p) < 8 ? (p) : ((p) < 14 ? (p) - 8 : (p) - 14))
+#define digitalPinToInterrupt(p) ((p) == 2 ? 0 : ((p) == 3 ? 1 : NOT_AN_INTERRUPT))
+
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper *>(PSTR(s)))
+
+class String {
+public:
+  String() {}
+  String(const char *text) : text(text) {}
+  String(char c) : text(1, c) {}
+  String &operator=(char c) { text.assign(1, c); return *this; }
+  String &operator+=(char c) { text += c; return *this; }
+  unsigned length() const { return text.size(); }
+  char operator[](unsigned i) const { return text[i]; }
+  const char *c_str() const { return text.c_str(); }
+
+private:
+  std::string text;
+};
+
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size) {
+    size_t n = 0;
+    while (size--) n += write(*buffer++);
+    return n;
+  }
+  size_t write(const char *text) { return write((const uint8_t *)text, strlen(text)); }
+  virtual int availableForWrite() { return 0; }
+  virtual void flush() {}
+
+  size_t print(const __FlashStringHelper *text) { return write((const char *)text); }
+  size_t print(const String &text) { return write(text.c_str()); }
+  size_t print(const char *text) { return write(text); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(unsigned char n, int base = DEC) { return print_number(n, base); }
+  size_t print(int n, int base = DEC) { return print((long)n, base); }
+  size_t print(unsigned int n, int base = DEC) { return print_number(n, base); }
+  size_t print(long n, int base = DEC) {
+    if (base == DEC && n < 0) return write('-') + print_number(-n, DEC);
+    return print_number((unsigned long)n, base);
+  }
+  size_t print(unsigned long n, int base = DEC) { return print_number(n, base); }
+  size_t print(double n, int digits = 2) {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.*f", digits, n);
+    return write(buffer);
+  }
+  size_t println() { return write("\r\n"); }
+  template <typename T> size_t println(T value) { return print(value) + println(); }
+  template <typename T> size_t println(T value, int format) { return print(value, format) + println(); }
+
+private:
+  size_t print_number(unsigned long n, int base) {
+    char buffer[33];
+    char *p = buffer + sizeof(buffer) - 1;
+    *p = 0;
+    if (base < 2) base = DEC;
+    do {
+      int digit = n % base;
+      *--p = digit < 10 ? '0' + digit : 'A' + digit - 10;
+      n /= base;
+    } while (n);
+    return write(p);
+  }
+};
+
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+};
+
+class HardwareSerial : public Stream {
+public:
+  using Print::write;
+  void begin(unsigned long baud) {}
+  int available() override;
+  int read() override;
+  int peek() override;
+  size_t write(uint8_t c) override;
+  int availableForWrite() override { return 63; }
+  void flush() override {}
+  operator bool() { return true; }
+};
+extern HardwareSerial Serial;
@@ -0,0 +1,23 @@
+#pragma once
+// Host build: 1 kB of EEPROM (ATmega328P) in RAM, see host.cpp
+#include <stdint.h>
+#include <string.h>
+#include <avr/io.h>
+#include <avr/eeprom.h>
+
+extern uint8_t hostEeprom[E2END + 1];
+void host_eeprom_write(int address, uint8_t value);  //Checked against the trace when replaying one
+
+struct EEPROMClass {
+  uint8_t read(int address) { return hostEeprom[address & E2END]; }
+  void write(int address, uint8_t value) { host_eeprom_write(address, value); }
+  void update(int address, uint8_t value) { if (read(address) != value) write(address, value); }
+  uint16_t length() { return E2END + 1; }
+  template <typename T> T &get(int address, T &value) { memcpy(&value, hostEeprom + address, sizeof(T)); return value; }
+  template <typename T> const T &put(int address, const T &value) {
+    const uint8_t *data = (const uint8_t *)&value;
+    for (size_t x = 0; x < sizeof(T); x++) update(address + x, data[x]);
+    return value;
+  }
+};
+static EEPROMClass EEPROM __attribute__((unused));
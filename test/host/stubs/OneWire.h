@@ -0,0 +1,31 @@
+#pragma once
+// Host build: the OneWire 2.3.5 interface. The bus routines are the simulated fobs of host_bus.cpp in the firmware,
+// or the library's own bit routines in the tests that put a master on a pin (onewire_master.cpp).
+#include <Arduino.h>
+
+class OneWire {
+public:
+  OneWire(uint8_t pin);
+  uint8_t reset(void);
+  void select(const uint8_t rom[8]);
+  void skip(void);
+  void write(uint8_t v, uint8_t power = 0);
+  uint8_t read(void);
+  void write_bit(uint8_t v);
+  uint8_t read_bit(void);
+  void depower(void);
+  void reset_search();
+  bool search(uint8_t *newAddr, bool search_mode = true);
+  static uint8_t crc8(const uint8_t *addr, uint8_t len);
+  static uint16_t crc16(const uint8_t *input, uint16_t len, uint16_t crc = 0);
+
+private:
+  uint8_t pin;
+  uint8_t bitmask;                      //The library's state...
+  volatile uint8_t *baseReg;
+  unsigned char ROM_NO[8];
+  uint8_t LastDiscrepancy;
+  uint8_t LastFamilyDiscrepancy;
+  bool LastDeviceFlag;
+  bool searched;                        //...and the one of host_bus.cpp
+};
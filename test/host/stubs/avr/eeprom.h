@@ -0,0 +1,3 @@
+#pragma once
+#define eeprom_is_ready() 1
+#define eeprom_busy_wait()
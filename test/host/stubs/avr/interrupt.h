@@ -0,0 +1,7 @@
+#pragma once
+// Host build: an interrupt handler is an ordinary function, the tests call it directly
+#define ISR(vector, ...) extern "C" void vector(void); extern "C" void vector(void)
+#define EMPTY_INTERRUPT(vector) extern "C" void vector(void); extern "C" void vector(void) {}
+#define ISR_NOBLOCK
+#define cli()
+#define sei()
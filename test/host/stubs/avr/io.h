@@ -0,0 +1,42 @@
+#pragma once
+// Host build: the ATmega328P registers the firmware touches, as plain variables (see host.cpp)
+#include <stdint.h>
+
+#ifndef F_CPU
+#define F_CPU 16000000UL
+#endif
+#define RAMEND 0x8FF
+#define E2END 0x3FF
+#define _BV(bit) (1 << (bit))
+
+extern volatile uint8_t SREG, MCUSR, SMCR, PRR, EECR;
+extern volatile uint8_t PCICR, PCIFR, PCMSK0, PCMSK1, PCMSK2, EIMSK, EICRA, EIFR;
+extern volatile uint8_t TIMSK0, OCR0A, WDTCSR;
+volatile uint8_t *host_timer0();        //Timer0 counts the host time at 16 MHz / 64, a read of it takes 1 us
+#define TCNT0 (*host_timer0())
+extern volatile uintptr_t SP;
+#define __data_start hostDataStart      //The AVR linker symbols of the RAM layout, the C runtime of the host has its own __data_start
+#define __heap_start hostHeapStart
+#define __stack hostStack
+
+#define SREG_I 7
+#define WDRF 3
+#define WDP0 0
+#define WDP1 1
+#define WDP2 2
+#define WDE 3
+#define WDCE 4
+#define WDP3 5
+#define WDIE 6
+#define PCIE0 0
+#define PCIE1 1
+#define PCIE2 2
+#define PCIF0 0
+#define TOIE0 0
+#define OCIE0A 1
+
+#define PCINT0_vect __vector_3
+#define PCINT1_vect __vector_4
+#define PCINT2_vect __vector_5
+#define WDT_vect __vector_6
+#define TIMER0_COMPA_vect __vector_14
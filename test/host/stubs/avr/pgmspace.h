@@ -0,0 +1,18 @@
+#pragma once
+// Host build: flash and RAM are the same address space
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PSTR(s) (s)
+typedef const char *PGM_P;
+typedef const void *PGM_VOID_P;
+#define pgm_read_byte(a) (*(const uint8_t *)(a))
+#define pgm_read_word(a) (*(const uint16_t *)(a))
+#define pgm_read_dword(a) (*(const uint32_t *)(a))
+#define pgm_read_ptr(a) (*(void *const *)(a))
+#define strlen_P strlen
+#define strcmp_P strcmp
+#define strncmp_P strncmp
+#define strcpy_P strcpy
+#define memcpy_P memcpy
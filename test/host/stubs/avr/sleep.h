@@ -0,0 +1,10 @@
+#pragma once
+// Host build: sleeping lets the host time pass (see host.cpp)
+#define SLEEP_MODE_IDLE 0
+#define SLEEP_MODE_PWR_DOWN 2
+#define set_sleep_mode(mode) ((void)(mode))
+#define sleep_enable()
+#define sleep_disable()
+#define sleep_bod_disable()
+void host_sleep();
+#define sleep_cpu() host_sleep()
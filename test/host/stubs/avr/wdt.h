@@ -0,0 +1,7 @@
+#pragma once
+#define WDTO_15MS 0
+#define WDTO_250MS 4
+#define WDTO_1S 6
+#define wdt_reset()
+#define wdt_enable(timeout)
+#define wdt_disable()
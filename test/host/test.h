@@ -0,0 +1,32 @@
+#pragma once
+// Host tests of the firmware: CHECK() what has to hold, test_result() is the exit status of main()
+#include <stdint.h>
+#include <stdio.h>
+
+#include <string>
+
+static int failures = 0;
+
+#define CHECK(condition, what) do { if (!(condition)) { printf("FAIL: %s\n", what); failures++; } } while (0)
+
+static inline int test_result(const char *name) {
+  if (failures == 0) printf("%s: OK\n", name);
+  return failures ? 1 : 0;
+}
+
+/* The firmware's console output, for host_serial_output(): kept in output, and every line (without the CR LF) goes to on_line() */
+static std::string output;
+static void (*on_line)(const std::string &line) = nullptr;
+
+static inline void console_output(uint8_t c) {
+  static std::string line;
+  output += (char)c;
+  if (c == '\r') return;
+  if (c != '\n') {
+    line += (char)c;
+    return;
+  }
+  std::string complete;
+  complete.swap(line);
+  if (on_line) on_line(complete);
+}
@@ -0,0 +1,71 @@
+# A traced session replayed by the host firmware: the output has to be the same, Byte for Byte
+#   cmake -DHOST_FIRMWARE=... -DTRACE_TOOL=... -DWORK=<dir> -P trace_replay_test.cmake
+set(FOB 01A1B2C3D4E5F68F)
+file(MAKE_DIRECTORY ${WORK})
+
+# EEPROM: slot F (the one the idle selector picks) holds 01 11 22 33 44 55 66 75 & a name with a 0xF5 in it,
+# followed by what would be a SERIAL_IN record if it wasn't escaped
+string(ASCII 255 erased)
+string(ASCII 245 marker)
+string(ASCII 2 type)
+set(image "${erased}")
+foreach(i RANGE 8)                      # 2^9 = 512 Bytes...
+  set(image "${image}${image}")
+endforeach()
+string(SUBSTRING "${image}" 0 480 image) # ...up to 0x1E0
+foreach(code 1 17 34 51 68 85 102 117)
+  string(ASCII ${code} c)
+  set(image "${image}${c}")
+endforeach()
+set(name "AB${marker}${type}CDEF")
+file(WRITE ${WORK}/initial.eeprom "${image}${name}")
+file(WRITE ${WORK}/input.txt "TSLRST")  # Trace, show the slot, list & read the fob to the slot, show it again, trace off
+
+function(firmware name expected_result)
+  execute_process(COMMAND ${HOST_FIRMWARE} --loops 100 ${ARGN}
+                  OUTPUT_FILE ${WORK}/${name}.bin ERROR_VARIABLE err RESULT_VARIABLE result TIMEOUT 120)
+  if(NOT result EQUAL expected_result)
+    message(FATAL_ERROR "${name}: exit status ${result}, expected ${expected_result}\n${err}")
+  endif()
+  set(err "${err}" PARENT_SCOPE)
+endfunction()
+
+function(copy from to)
+  execute_process(COMMAND ${CMAKE_COMMAND} -E copy ${WORK}/${from} ${WORK}/${to})
+endfunction()
+
+function(same a b)
+  execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files ${WORK}/${a} ${WORK}/${b} RESULT_VARIABLE result)
+  if(NOT result EQUAL 0)
+    message(FATAL_ERROR "${a} and ${b} differ")
+  endif()
+endfunction()
+
+# Recorded with the fob on the contacts, one input Byte a second. The replay has no fob, the bus results come from the trace.
+copy(initial.eeprom recorded.eeprom)
+firmware(recorded 0 --eeprom ${WORK}/recorded.eeprom --blank ${FOB} --gap 1000000 INPUT_FILE ${WORK}/input.txt)
+copy(initial.eeprom replayed.eeprom)
+firmware(replayed 0 --eeprom ${WORK}/replayed.eeprom --replay ${WORK}/recorded.bin)
+same(recorded.bin replayed.bin)
+same(recorded.eeprom replayed.eeprom)
+
+execute_process(COMMAND ${TRACE_TOOL} decode -t ${WORK}/recorded.bin OUTPUT_VARIABLE decoded RESULT_VARIABLE result)
+message(STATUS "--- decoded\n${decoded}")
+foreach(pattern
+    "START v2"
+    "SERIAL_RX 1 Bytes arrived"
+    "\\| \\[INFO\\] Reading code from device slot\\.\\.\\. F : ${name} : 0x01, 0x11"   # The escaped 0xF5 is text again
+    "BUS_SEARCH pin 10: 01 A1 B2 C3 D4 E5 F6 8F"
+    "EEPROM_WRITE 0x1E7 = 0x8F"
+    "\\| \\[INFO\\] Reading code from device slot\\.\\.\\. F : ${name} : 0x01, 0xA1")
+  if(NOT result EQUAL 0 OR NOT decoded MATCHES "${pattern}")
+    message(FATAL_ERROR "decode: no match for \"${pattern}\"")
+  endif()
+endforeach()
+
+# Started from where the recording ended (the fob's ID already in the slot): the EEPROM writes differ, the replay has to notice
+copy(recorded.eeprom diverged.eeprom)
+firmware(diverged 1 --eeprom ${WORK}/diverged.eeprom --replay ${WORK}/recorded.bin)
+if(NOT err MATCHES "Diverged at t = [0-9]+ us: recorded EEPROM_WRITE [0-9A-F ]+, the firmware did ")
+  message(FATAL_ERROR "diverged: ${err}")
+endif()
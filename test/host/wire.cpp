@@ -0,0 +1,106 @@
+/*
+ * Host build: the firmware's IBUTTON pin wired to a second MCU's pin, a 1-Wire master
+ *
+ * The line is low while either side pulls it low (its DDR bit set & PORT bit clear), both PIN registers read it.
+ * A change of the line sets PCIF0 while the pin is in PCMSK0, like on the ATmega328P, and with PCIE0 in PCICR the
+ * firmware's PCINT0_vect runs 1 us later, in its own context: it waits in simulated time like the master does,
+ * and whichever side is due first runs. Writing PCIF0 to PCIFR clears the flag, a change meanwhile runs it again.
+ */
+#include "wire.h"
+
+#include "host.h"
+
+#include <ucontext.h>
+
+extern "C" void PCINT0_vect(void);
+
+#define SLAVE_PORT digitalPinToPort(WIRE_SLAVE_PIN)
+#define SLAVE_MASK digitalPinToBitMask(WIRE_SLAVE_PIN)
+#define MASTER_PORT digitalPinToPort(WIRE_MASTER_PIN)
+#define MASTER_MASK digitalPinToBitMask(WIRE_MASTER_PIN)
+#define LATENCY_US 1
+
+static ucontext_t mainContext, isrContext;
+static char isrStack[64 * 1024];
+static bool inIsr = false;              //Running in the interrupt's context...
+static bool isrRunning = false;         //...or the interrupt is waiting there...
+static unsigned long isrWakeAt;         //...until then
+static bool lineLow = false;
+static bool flagged = false;            //PCIF0
+static unsigned long flaggedAt;
+
+static bool pulls_low(uint8_t port, uint8_t mask) {
+  return (hostDdr[port] & mask) && !(hostPort[port] & mask);
+}
+
+static void update() {                  //The line after the register writes since the last time, & PCIF0
+  bool low = pulls_low(SLAVE_PORT, SLAVE_MASK) || pulls_low(MASTER_PORT, MASTER_MASK);
+  if (low != lineLow) {
+    lineLow = low;
+    if (low) {
+      hostPin[SLAVE_PORT] &= ~SLAVE_MASK;
+      hostPin[MASTER_PORT] &= ~MASTER_MASK;
+    } else {
+      hostPin[SLAVE_PORT] |= SLAVE_MASK;
+      hostPin[MASTER_PORT] |= MASTER_MASK;
+    }
+    if ((PCMSK0 & SLAVE_MASK) && !flagged) {
+      flagged = true;
+      flaggedAt = hostUs;
+    }
+  }
+  if (PCIFR & _BV(PCIF0)) {             //Written by the firmware, that clears it
+    PCIFR = 0;
+    flagged = false;
+  }
+}
+
+static void isr() {
+  PCINT0_vect();
+  update();
+  isrRunning = false;
+}                                       //Back to mainContext
+
+static void advance(unsigned long us) {
+  update();
+  if (inIsr) {                          //The interrupt waits, the master runs meanwhile
+    isrWakeAt = hostUs + us;
+    swapcontext(&isrContext, &mainContext);
+    return;
+  }
+  unsigned long until = hostUs + us;
+  while (true) {
+    unsigned long next;
+    if (isrRunning) {
+      next = isrWakeAt;
+    } else if (flagged && (PCICR & _BV(PCIE0))) {
+      next = flaggedAt + LATENCY_US;
+    } else {
+      break;
+    }
+    if (next > until) break;
+    if (next > hostUs) hostUs = next;
+    if (!isrRunning) {                  //The hardware clears the flag as the interrupt starts
+      flagged = false;
+      isrRunning = true;
+      getcontext(&isrContext);
+      isrContext.uc_stack.ss_sp = isrStack;
+      isrContext.uc_stack.ss_size = sizeof(isrStack);
+      isrContext.uc_link = &mainContext;
+      makecontext(&isrContext, isr, 0);
+    }
+    inIsr = true;
+    swapcontext(&mainContext, &isrContext);
+    inIsr = false;
+  }
+  hostUs = until;
+  update();
+}
+
+void wire_begin() {
+  hostPin[SLAVE_PORT] |= SLAVE_MASK;
+  hostPin[MASTER_PORT] |= MASTER_MASK;
+  lineLow = false;
+  flagged = isrRunning = false;
+  hostAdvance = advance;
+}
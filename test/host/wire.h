@@ -0,0 +1,8 @@
+#pragma once
+// Host build: the firmware's IBUTTON pin wired to a second MCU's pin, a 1-Wire master (see wire.cpp)
+#include <stdint.h>
+
+#define WIRE_SLAVE_PIN 10               //IBUTTON of the firmware
+#define WIRE_MASTER_PIN 11              //The master's pin, e.g. a OneWire of onewire_master.cpp
+
+void wire_begin();                      //Joins the pins & runs PCINT0_vect whenever a change of the line fires it
@@ -0,0 +1,438 @@
+/*
+ * batch_clone - host side batch cloning for the iButton Cloner serial console
+ *
+ * Reads a CSV of IDs (& optional names) and clones them one by one, driving the
+ * device's own console commands, the same ones an operator would type:
+ *   'A'         advanced mode, needed by 'M'
+ *   'M' + slot  select the staging memory slot
+ *   'E' + code  edit the slot (8 Bytes in advanced mode) + name
+ *   '|'         wait for the next fob
+ *   'W', 'V'    write it & verify it against the slot
+ *   'L'         polled until the fob is taken off the contacts
+ * Commands are pipelined: "|WV" of one item goes together with "M" & "E" of the next one,
+ * as long as it all fits the device's serial RX buffer (-r).
+ *
+ * Build (Linux / macOS):
+ *   g++ -std=c++11 -O2 -Wall -o batch_clone tools/batch_clone/batch_clone.cpp
+ *
+ * Usage:
+ *   batch_clone [options] <serial port or pty> <ids.csv>
+ *
+ * CSV: one fob per line, "ID[,NAME]". ID is 14 hex digits (the CRC is computed) or all 16,
+ * spaces, ':' and '-' are ignored. NAME is up to 8 characters. Empty lines, lines starting
+ * with '#' and a header line (first field not hex) are skipped.
+ *
+ * Any tty path works, so it can be run against a pty, e.g. one connected to simavr's UART.
+ */
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+struct Options {
+  const char *port = nullptr;
+  const char *csv = nullptr;
+  int baud = 115200;
+  int slot = 0xF;             //Memory slot the IDs are staged in. Its previous content is overwritten!
+  size_t rxBuffer = 63;       //Device serial RX buffer (Bytes it can take while busy), 63 on the AVR boards
+  double stepTimeout = 30;    //Seconds for a console response
+  double fobTimeout = 0;      //Seconds to wait for a fob, 0 = forever
+  double pollInterval = 0.3;  //Seconds between the 'L' polls for fob removal
+  bool verbose = false;       //Echo all the device output
+};
+
+struct Item {
+  int line;
+  unsigned char id[8];
+  std::string name;
+};
+
+enum Result { RESULT_OK, RESULT_VERIFY_FAILED, RESULT_WRITE_FAILED, RESULT_TIMEOUT };
+const char *RESULT_NAMES[] = {"OK", "VERIFY FAILED", "WRITE FAILED", "TIMEOUT"};
+
+unsigned char crc8(const unsigned char *data, int len) { //Dallas / Maxim 1-Wire CRC8, the same as OneWire::crc8()
+  unsigned char crc = 0;
+  while (len--) {
+    unsigned char in = *data++;
+    for (int i = 0; i < 8; i++) {
+      unsigned char mix = (crc ^ in) & 1;
+      crc >>= 1;
+      if (mix) crc ^= 0x8C;
+      in >>= 1;
+    }
+  }
+  return crc;
+}
+
+std::string trim(const std::string &s) {
+  size_t a = s.find_first_not_of(" \t\r\n");
+  if (a == std::string::npos) return "";
+  size_t b = s.find_last_not_of(" \t\r\n");
+  return s.substr(a, b - a + 1);
+}
+
+std::string unquote(const std::string &s) {
+  std::string t = trim(s);
+  if (t.size() >= 2 && t.front() == '"' && t.back() == '"') t = t.substr(1, t.size() - 2);
+  return t;
+}
+
+bool parse_id(const std::string &field, unsigned char id[8], std::string &error) { //14 or 16 hex digits, like the 'Q' clone queue takes them
+  std::string hex;
+  for (char c : field) {
+    if (c == ' ' || c == ':' || c == '-') continue;
+    if (!isxdigit((unsigned char)c)) {
+      error = "not a hex ID";
+      return false;
+    }
+    hex += c;
+  }
+  if (hex.size() != 14 && hex.size() != 16) {
+    error = "ID must have 14 or 16 hex digits";
+    return false;
+  }
+  for (size_t x = 0; x < hex.size() / 2; x++) {
+    id[x] = (unsigned char)strtoul(hex.substr(2 * x, 2).c_str(), nullptr, 16);
+  }
+  if (id[0] == 0x00) {
+    error = "zero family code";
+    return false;
+  }
+  if (hex.size() == 14) {
+    id[7] = crc8(id, 7);
+  } else if (crc8(id, 7) != id[7]) {
+    error = "CRC doesn't match";
+    return false;
+  }
+  return true;
+}
+
+bool load_csv(const char *path, std::vector<Item> &items) {
+  std::ifstream file(path);
+  if (!file) {
+    fprintf(stderr, "[ERROR] Can't open %s\n", path);
+    return false;
+  }
+  std::string line;
+  int number = 0;
+  bool ok = true;
+  while (std::getline(file, line)) {
+    number++;
+    std::string text = trim(line);
+    if (text.empty() || text[0] == '#') continue;
+
+    size_t comma = text.find(',');
+    std::string idField = unquote(text.substr(0, comma));
+    Item item;
+    item.line = number;
+    std::string error;
+    if (!parse_id(idField, item.id, error)) {
+      if (items.empty() && ok && error == "not a hex ID") continue;  //Header line
+      fprintf(stderr, "[ERROR] %s:%d: %s\n", path, number, error.c_str());
+      ok = false;
+      continue;
+    }
+    if (comma != std::string::npos) item.name = unquote(text.substr(comma + 1));
+    if (item.name.size() > 8) {
+      fprintf(stderr, "[WARNING] %s:%d: name cut to 8 characters\n", path, number);
+      item.name.resize(8);
+    }
+    items.push_back(item);
+  }
+  return ok;
+}
+
+std::string id_hex(const unsigned char id[8]) {
+  char buf[17];
+  for (int x = 0; x < 8; x++) snprintf(buf + 2 * x, 3, "%02X", id[x]);
+  return buf;
+}
+
+std::string edit_code(const unsigned char id[8]) { //The "0x01, 0x02, ..." format serial_parse_hex() expects, all 8 Bytes in advanced mode
+  std::string code;
+  char buf[8];
+  for (int x = 0; x < 8; x++) {
+    snprintf(buf, sizeof(buf), x < 7 ? "0x%02X, " : "0x%02X", id[x]);
+    code += buf;
+  }
+  return code;
+}
+
+class Console {
+public:
+  explicit Console(bool verbose) : verbose(verbose) {}
+  ~Console() {
+    if (fd >= 0) close(fd);
+  }
+
+  bool open_port(const char *path, int baud) {
+    fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0) {
+      perror(path);
+      return false;
+    }
+    termios tio;
+    if (tcgetattr(fd, &tio) == 0) {
+      cfmakeraw(&tio);
+      tio.c_cflag |= CLOCAL | CREAD;
+      tio.c_cc[VMIN] = 0;
+      tio.c_cc[VTIME] = 0;
+      speed_t speed = baud_constant(baud);
+      cfsetispeed(&tio, speed);
+      cfsetospeed(&tio, speed);
+      tcsetattr(fd, TCSANOW, &tio);
+      tcflush(fd, TCIOFLUSH);
+    }
+    return true;
+  }
+
+  bool send(const std::string &text) {
+    if (verbose) printf(">> %s\n", text.c_str());
+    size_t done = 0;
+    while (done < text.size()) {
+      ssize_t n = write(fd, text.data() + done, text.size() - done);
+      if (n < 0) {
+        if (errno != EAGAIN) {
+          perror("write");
+          return false;
+        }
+        pollfd p = {fd, POLLOUT, 0};
+        poll(&p, 1, 100);
+        continue;
+      }
+      done += n;
+    }
+    return true;
+  }
+
+  bool read_line(std::string &line, double timeout) { //FALSE on timeout, timeout < 0 = forever
+    Clock::time_point deadline = Clock::now() + std::chrono::milliseconds((long)(timeout * 1000));
+    while (true) {
+      size_t eol = rx.find('\n');
+      if (eol != std::string::npos) {
+        line = rx.substr(0, eol);
+        rx.erase(0, eol + 1);
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (verbose) printf("<< %s\n", line.c_str());
+        return true;
+      }
+      int wait = 100;
+      if (timeout >= 0) {
+        long left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+        if (left <= 0) return false;
+        if (left < wait) wait = (int)left;
+      }
+      pollfd p = {fd, POLLIN, 0};
+      if (poll(&p, 1, wait) > 0) {
+        char buf[256];
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n > 0) rx.append(buf, n);
+      }
+    }
+  }
+
+  int wait_for(const std::vector<std::string> &patterns, double timeout) { //Index of the first pattern a line contains, -1 on timeout
+    Clock::time_point deadline = Clock::now() + std::chrono::milliseconds((long)(timeout * 1000));
+    std::string line;
+    while (true) {
+      double left = timeout;
+      if (timeout >= 0) {
+        left = std::chrono::duration<double>(deadline - Clock::now()).count();
+        if (left <= 0) return -1;
+      }
+      if (!read_line(line, left)) return -1;
+      for (size_t x = 0; x < patterns.size(); x++) {
+        if (line.find(patterns[x]) != std::string::npos) return (int)x;
+      }
+    }
+  }
+
+  void drain(double quiet) { //Drops the output until it's quiet for a while
+    std::string line;
+    while (read_line(line, quiet));
+    rx.clear();
+  }
+
+private:
+  static speed_t baud_constant(int baud) {
+    switch (baud) {
+      case 9600: return B9600;
+      case 19200: return B19200;
+      case 38400: return B38400;
+      case 57600: return B57600;
+      default: return B115200;
+    }
+  }
+
+  int fd = -1;
+  bool verbose;
+  std::string rx;
+};
+
+const char NAME_PROMPT[] = "[INPUT] Waiting for name";
+const char INPUT_CLEARED[] = "[WARNING] Clearing serial input";  //edit_slot() drops the input after the name, only send after this
+
+void usage() {
+  fprintf(stderr,
+    "Usage: batch_clone [options] <serial port or pty> <ids.csv>\n"
+    "  -b <baud>     baud rate (default 115200)\n"
+    "  -s <slot>     memory slot 0-F to stage the IDs in, it's overwritten (default F)\n"
+    "  -r <bytes>    device serial RX buffer, limits the pipelining (default 63)\n"
+    "  -t <seconds>  give up waiting for a fob after this long (default: wait forever)\n"
+    "  -v            echo the device output\n");
+}
+
+bool parse_options(int argc, char **argv, Options &opt) {
+  int c;
+  while ((c = getopt(argc, argv, "b:s:r:t:v")) != -1) {
+    switch (c) {
+      case 'b': opt.baud = atoi(optarg); break;
+      case 's': opt.slot = (int)strtol(optarg, nullptr, 16); break;
+      case 'r': opt.rxBuffer = (size_t)atoi(optarg); break;
+      case 't': opt.fobTimeout = atof(optarg); break;
+      case 'v': opt.verbose = true; break;
+      default: return false;
+    }
+  }
+  if (argc - optind != 2 || opt.slot < 0 || opt.slot > 0xF) return false;
+  opt.port = argv[optind];
+  opt.csv = argv[optind + 1];
+  return true;
+}
+
+bool stage(Console &console, const Options &opt, const Item &item) { //Finishes the 'E' of the item: name & the input clearing
+  if (console.wait_for({NAME_PROMPT, "[ERROR]"}, opt.stepTimeout) != 0) return false;
+  if (!console.send(item.name + "\n")) return false;
+  return console.wait_for({INPUT_CLEARED}, opt.stepTimeout) == 0;
+}
+
+std::string stage_command(const Options &opt, const Item &item) {
+  char select[4];
+  snprintf(select, sizeof(select), "M%X", opt.slot);
+  return std::string(select) + "E" + edit_code(item.id);
+}
+
+int main(int argc, char **argv) {
+  Options opt;
+  if (!parse_options(argc, argv, opt)) {
+    usage();
+    return 2;
+  }
+  std::vector<Item> items;
+  if (!load_csv(opt.csv, items)) return 2;
+  if (items.empty()) {
+    fprintf(stderr, "[ERROR] No IDs in %s\n", opt.csv);
+    return 2;
+  }
+
+  Console console(opt.verbose);
+  if (!console.open_port(opt.port, opt.baud)) return 1;
+  console.wait_for({"===Welcome"}, 3);        //Opening the port resets most boards
+  console.drain(0.3);
+
+  if (!console.send("A")) return 1;           //'M' needs the advanced mode
+  int mode = console.wait_for({"has been ENABLED", "has been DISABLED"}, opt.stepTimeout);
+  if (mode == 1) {
+    console.send("A");
+    mode = console.wait_for({"has been ENABLED", "has been DISABLED"}, opt.stepTimeout) == 0 ? 2 : -1;
+  }
+  if (mode < 0) {
+    fprintf(stderr, "[ERROR] No response from the device console on %s\n", opt.port);
+    return 1;
+  }
+  bool restoreAdvanced = mode == 0;           //It was off before we switched it on
+
+  printf("[INFO] %zu IDs, staged in slot %X. Present the fobs one by one, take each one off after its result.\n", items.size(), opt.slot);
+  std::string command = stage_command(opt, items[0]);
+  if (!console.send(command) || !stage(console, opt, items[0])) {
+    fprintf(stderr, "[ERROR] Couldn't stage the first ID\n");
+    return 1;
+  }
+
+  int counts[4] = {0, 0, 0, 0};
+  double cycleSum = 0;
+  Clock::time_point started = Clock::now();
+  for (size_t i = 0; i < items.size(); i++) {
+    const Item &item = items[i];
+    const Item *next = i + 1 < items.size() ? &items[i + 1] : nullptr;
+
+    command = "|WV";
+    bool pipelined = next && command.size() + stage_command(opt, *next).size() <= opt.rxBuffer;
+    if (pipelined) command += stage_command(opt, *next);
+    if (!console.send(command)) return 1;
+
+    Result result = RESULT_TIMEOUT;
+    if (console.wait_for({"has been successfully detected"}, opt.fobTimeout > 0 ? opt.fobTimeout : -1) == 0) {
+      Clock::time_point detected = Clock::now();
+      int write = console.wait_for({"was written to the iButton", "doesn't read back", "attemt to write"}, opt.stepTimeout);
+      if (write == 1) console.wait_for({"attemt to write"}, opt.stepTimeout);  //Its [ERROR] isn't the verify's
+      bool written = write == 0 || write == 1;  //A write that doesn't read back is a verify failure
+      int verified = console.wait_for({"[SUCCESS] An iButton address matches", "[ERROR]"}, opt.stepTimeout);
+      if (verified == 0) {
+        result = RESULT_OK;
+      } else if (verified == 1) {
+        result = written ? RESULT_VERIFY_FAILED : RESULT_WRITE_FAILED;
+      }
+      double cycle = std::chrono::duration<double>(Clock::now() - detected).count();
+      cycleSum += cycle;
+      printf("[%3zu/%zu] %s %-8s %-13s %5.1f s\n", i + 1, items.size(), id_hex(item.id).c_str(), item.name.c_str(),
+             RESULT_NAMES[result], cycle);
+    } else {
+      printf("[%3zu/%zu] %s %-8s %s\n", i + 1, items.size(), id_hex(item.id).c_str(), item.name.c_str(), RESULT_NAMES[result]);
+    }
+    fflush(stdout);
+    counts[result]++;
+    if (result == RESULT_TIMEOUT) {
+      fprintf(stderr, "[ERROR] Gave up waiting for the fob, stopping the batch.\n");
+      break;
+    }
+    if (!next) break;
+
+    if (!pipelined && !console.send(stage_command(opt, *next))) return 1;
+    if (!stage(console, opt, *next)) {
+      fprintf(stderr, "[ERROR] Couldn't stage the ID from line %d, stopping the batch.\n", next->line);
+      break;
+    }
+
+    printf("[INFO] Take the fob off the contacts.\n");
+    fflush(stdout);
+    while (true) {                            //Otherwise the next '|' would take the same fob again
+      console.send("L");
+      int listed = console.wait_for({"[SUCCESS]", "attemt to read"}, opt.stepTimeout);
+      if (listed == 1) break;
+      if (listed < 0) return 1;
+      std::this_thread::sleep_for(std::chrono::milliseconds((long)(opt.pollInterval * 1000)));
+    }
+  }
+
+  if (counts[RESULT_TIMEOUT] > 0) {          //'|' can't be interrupted, the rest of the command line runs on the next fob
+    fprintf(stderr, "[WARNING] The device still waits for a fob, with \"WV\" queued. Reset it before the next batch.\n");
+  } else if (restoreAdvanced) {
+    console.send("A");
+    console.wait_for({"has been DISABLED"}, opt.stepTimeout);
+  }
+
+  double elapsed = std::chrono::duration<double>(Clock::now() - started).count();
+  int done = counts[RESULT_OK] + counts[RESULT_VERIFY_FAILED] + counts[RESULT_WRITE_FAILED];
+  printf("\n[DONE] OK: %d, verify failed: %d, write failed: %d, not done: %zu\n", counts[RESULT_OK],
+         counts[RESULT_VERIFY_FAILED], counts[RESULT_WRITE_FAILED], items.size() - done);
+  if (done > 0) {
+    printf("[INFO] Elapsed: %.0f s, average clone cycle: %.1f s, throughput: %.0f fobs/hour\n", elapsed, cycleSum / done,
+           elapsed > 0 ? counts[RESULT_OK] * 3600.0 / elapsed : 0.0);
+  }
+  return counts[RESULT_OK] == (int)items.size() ? 0 : 1;
+}
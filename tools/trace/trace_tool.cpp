@@ -0,0 +1,538 @@
+/*
+ * trace_tool - capture, decode & replay the iButton Cloner traces ('T' command, USE_TRACE)
+ *
+ * While tracing, the firmware mixes binary records into its console output:
+ *   0xF5, type, microseconds since the previous record (LEB128), payload (fixed length per type)
+ * Everything that isn't a record is text. Within a session (START to STOP) a 0xF5 of the text comes as 0xF5 0x00.
+ *
+ * Build (Linux / macOS):
+ *   g++ -std=c++11 -O2 -Wall -o trace_tool tools/trace/trace_tool.cpp
+ *
+ * Usage:
+ *   trace_tool capture [-b baud] <port> <trace.bin>
+ *       Starts the trace, forwards stdin to the device (type the commands as usual, Ctrl-D ends),
+ *       shows the console text & saves the whole raw output.
+ *   trace_tool decode [-t] <trace.bin>
+ *       Record timeline (-t: with the console text) and a profile: records per type, longest gaps.
+ *   trace_tool replay [-b baud] <trace.bin> <port> <replay.bin>
+ *       Sends the recorded serial input to the device again, each Byte at the time the device noticed it after the start,
+ *       captures the new trace & compares it with the recorded one.
+ *   trace_tool compare <recorded.bin> <replayed.bin>
+ *       Compares the first traced session of both: where they diverge, and the timing deltas of the matching records.
+ *       When the input arrived (SERIAL_RX) is left out, a replay over a real port can't reproduce it to the microsecond.
+ *
+ * The replay target is any tty path - the same unit, another one, or a pty of a simulator (e.g. simavr's UART).
+ * For a deterministic replay, with the 1-Wire bus results as recorded too, see the host build (test/host, --replay).
+ */
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+const unsigned char TRACE_MARKER = 0xF5;
+const unsigned char TRACE_ESCAPE = 0x00;
+const int TRACE_VERSION = 2;
+
+enum RecordType {                 //Same as TRACE_* in src/main.cpp
+  START = 0x01, SERIAL_IN, BUS_RESET, BUS_WRITE, BUS_READ, BUS_WRITE_BIT, BUS_READ_BIT, BUS_SEARCH, PULSES, EEPROM_WRITE, LOST, STOP,
+  SERIAL_RX
+};
+
+struct TypeInfo {
+  const char *name;
+  int payload;                    //Bytes
+};
+const TypeInfo TYPES[] = {
+  {"?", 0},
+  {"START", 5}, {"SERIAL_IN", 1}, {"BUS_RESET", 2}, {"BUS_WRITE", 2}, {"BUS_READ", 2}, {"BUS_WRITE_BIT", 2}, {"BUS_READ_BIT", 2},
+  {"BUS_SEARCH", 10}, {"PULSES", 2}, {"EEPROM_WRITE", 3}, {"LOST", 2}, {"STOP", 0}, {"SERIAL_RX", 1},
+};
+const int TYPE_COUNT = sizeof(TYPES) / sizeof(TYPES[0]);
+
+struct Record {
+  int type;
+  unsigned long long us;          //Since the START of its session
+  unsigned long delta;            //As recorded, since the previous record
+  std::vector<unsigned char> payload;
+  size_t textBefore;              //Console text Bytes received before it, to interleave the text in the timeline
+};
+
+struct Session {                  //From a START to its STOP (or the end of the capture)
+  std::vector<Record> records;
+  bool stopped = false;
+  unsigned long lost = 0;
+};
+
+class Parser {                    //Splits a raw console capture into the text & the records, can be fed in pieces
+public:
+  void feed(const unsigned char *data, size_t len) {
+    pending.insert(pending.end(), data, data + len);
+    size_t pos = 0;
+    while (pos < pending.size()) {
+      if (pending[pos] != TRACE_MARKER) {
+        text += (char)pending[pos++];
+        continue;
+      }
+      if (pos + 1 == pending.size()) break;      //Incomplete, wait for more
+      bool inSession = !sessions.empty() && !sessions.back().stopped;
+      if (inSession && pending[pos + 1] == TRACE_ESCAPE) {
+        text += (char)TRACE_MARKER;
+        pos += 2;
+        continue;
+      }
+      if (!inSession && pending[pos + 1] != START) { //Outside of a session the text isn't escaped
+        text += (char)pending[pos++];
+        continue;
+      }
+      Record record;
+      int used = parse(pending, pos, record);
+      if (used == 0) break;       //Incomplete, wait for more
+      if (used < 0) {             //Not a record after all
+        text += (char)pending[pos++];
+        continue;
+      }
+      add(record);
+      pos += used;
+    }
+    pending.erase(pending.begin(), pending.begin() + pos);
+  }
+
+  std::vector<Session> sessions;
+  std::string text;
+
+private:
+  static int parse(const std::vector<unsigned char> &buf, size_t pos, Record &record) { //Bytes used, 0 = incomplete, -1 = invalid
+    size_t at = pos + 1;
+    if (at >= buf.size()) return 0;
+    record.type = buf[at++];
+    if (record.type <= 0 || record.type >= TYPE_COUNT) return -1;
+    record.delta = 0;
+    for (int shift = 0;; shift += 7) {
+      if (shift > 28) return -1;
+      if (at >= buf.size()) return 0;
+      unsigned char b = buf[at++];
+      record.delta |= (unsigned long)(b & 0x7F) << shift;
+      if (!(b & 0x80)) break;
+    }
+    size_t len = TYPES[record.type].payload;
+    if (at + len > buf.size()) return 0;
+    record.payload.assign(buf.begin() + at, buf.begin() + at + len);
+    return (int)(at + len - pos);
+  }
+
+  void add(Record &record) {
+    record.textBefore = text.size();
+    if (record.type == START) {
+      sessions.push_back(Session());
+      now = 0;
+      if (record.payload[0] != TRACE_VERSION) fprintf(stderr, "[WARNING] Trace format version %d, expected %d\n", record.payload[0], TRACE_VERSION);
+    } else {
+      if (sessions.empty() || sessions.back().stopped) {
+        fprintf(stderr, "[WARNING] Record outside of a session (its START is missing), ignored\n");
+        return;
+      }
+      now += record.delta;
+    }
+    record.us = now;
+    Session &session = sessions.back();
+    if (record.type == LOST) session.lost += record.payload[0] | record.payload[1] << 8;
+    if (record.type == STOP) session.stopped = true;
+    session.records.push_back(record);
+  }
+
+  std::vector<unsigned char> pending;
+  unsigned long long now = 0;
+};
+
+std::string describe(const Record &r) {
+  char buf[96];
+  const std::vector<unsigned char> &p = r.payload;
+  switch (r.type) {
+    case START:
+      snprintf(buf, sizeof(buf), "START v%d, %lu us after boot", p[0], p[1] | p[2] << 8 | (unsigned long)p[3] << 16 | (unsigned long)p[4] << 24);
+      break;
+    case SERIAL_RX: snprintf(buf, sizeof(buf), "SERIAL_RX %d Bytes arrived", p[0]); break;
+    case SERIAL_IN:
+      if (p[0] >= 0x20 && p[0] < 0x7F) snprintf(buf, sizeof(buf), "SERIAL_IN '%c'", p[0]);
+      else snprintf(buf, sizeof(buf), "SERIAL_IN 0x%02X", p[0]);
+      break;
+    case BUS_RESET: snprintf(buf, sizeof(buf), "BUS_RESET pin %d: %s", p[0], p[1] ? "presence" : "nothing"); break;
+    case BUS_WRITE: case BUS_READ: case BUS_WRITE_BIT: case BUS_READ_BIT: case PULSES:
+      snprintf(buf, sizeof(buf), "%s pin %d: 0x%02X", TYPES[r.type].name, p[0], p[1]);
+      break;
+    case BUS_SEARCH:
+      if (!p[1]) {
+        snprintf(buf, sizeof(buf), "BUS_SEARCH pin %d: nothing", p[0]);
+      } else {
+        int n = snprintf(buf, sizeof(buf), "BUS_SEARCH pin %d:", p[0]);
+        for (int x = 0; x < 8; x++) n += snprintf(buf + n, sizeof(buf) - n, " %02X", p[2 + x]);
+      }
+      break;
+    case EEPROM_WRITE: snprintf(buf, sizeof(buf), "EEPROM_WRITE 0x%03X = 0x%02X", p[0] | p[1] << 8, p[2]); break;
+    case LOST: snprintf(buf, sizeof(buf), "LOST %d records (console queue full)", p[0] | p[1] << 8); break;
+    default: snprintf(buf, sizeof(buf), "%s", TYPES[r.type].name); break;
+  }
+  return buf;
+}
+
+bool same(const Record &a, const Record &b) {
+  return a.type == b.type && a.payload == b.payload;
+}
+
+bool load(const char *path, Parser &parser) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    fprintf(stderr, "[ERROR] Can't open %s\n", path);
+    return false;
+  }
+  std::vector<unsigned char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  parser.feed(data.data(), data.size());
+  if (parser.sessions.empty()) {
+    fprintf(stderr, "[ERROR] No trace in %s\n", path);
+    return false;
+  }
+  return true;
+}
+
+void print_text(const std::string &text, size_t &from, size_t to) { //Complete console lines in text[from, to)
+  while (from < to) {
+    size_t eol = text.find('\n', from);
+    if (eol == std::string::npos || eol >= to) break;
+    std::string line = text.substr(from, eol - from);
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    if (!line.empty()) printf("%30s| %s\n", "", line.c_str());
+    from = eol + 1;
+  }
+}
+
+int decode(const char *path, bool withText) {
+  Parser parser;
+  if (!load(path, parser)) return 1;
+  size_t textAt = 0;
+  for (size_t s = 0; s < parser.sessions.size(); s++) {
+    const Session &session = parser.sessions[s];
+    printf("===Session %zu===\n%14s %14s  record\n", s + 1, "t [us]", "+delta [us]");
+    for (const Record &r : session.records) {
+      if (withText) print_text(parser.text, textAt, r.textBefore);
+      printf("%14llu %14lu  %s\n", r.us, r.delta, describe(r).c_str());
+    }
+
+    int counts[TYPE_COUNT] = {0};
+    std::vector<size_t> gaps;
+    for (size_t x = 0; x < session.records.size(); x++) {
+      counts[session.records[x].type]++;
+      if (x > 0) gaps.push_back(x);
+    }
+    std::sort(gaps.begin(), gaps.end(), [&](size_t a, size_t b) { return session.records[a].delta > session.records[b].delta; });
+
+    unsigned long long duration = session.records.empty() ? 0 : session.records.back().us;
+    printf("\n[INFO] Duration: %.3f s, records: %zu%s\n", duration / 1e6, session.records.size(), session.stopped ? "" : " (no STOP, capture ended)");
+    if (session.lost) printf("[WARNING] %lu records were lost, the timeline has holes\n", session.lost);
+    for (int t = 1; t < TYPE_COUNT; t++) {
+      if (counts[t]) printf("  %-14s %6d\n", TYPES[t].name, counts[t]);
+    }
+    printf("[INFO] Longest gaps:\n");
+    for (size_t x = 0; x < gaps.size() && x < 5; x++) {
+      const Record &r = session.records[gaps[x]];
+      printf("  %10lu us before %s (at %llu us), after %s\n", r.delta, describe(r).c_str(), r.us, describe(session.records[gaps[x] - 1]).c_str());
+    }
+    printf("\n");
+  }
+  if (withText) print_text(parser.text, textAt, parser.text.size());
+  return 0;
+}
+
+Session without_arrivals(const Session &session) { //The SERIAL_RX records left out
+  Session result = session;
+  result.records.erase(std::remove_if(result.records.begin(), result.records.end(), [](const Record &r) { return r.type == SERIAL_RX; }),
+                       result.records.end());
+  for (size_t x = 1; x < result.records.size(); x++) result.records[x].delta = result.records[x].us - result.records[x - 1].us;
+  return result;
+}
+
+int compare(const Session &recorded, const Session &replayed) {
+  Session a = without_arrivals(recorded), b = without_arrivals(replayed);
+  size_t n = std::min(a.records.size(), b.records.size());
+  size_t matched = 0;
+  double sum = 0;
+  long long worst = 0;
+  size_t worstAt = 0;
+  std::vector<size_t> order;
+  for (; matched < n; matched++) {
+    if (!same(a.records[matched], b.records[matched])) break;
+    long long dt = (long long)b.records[matched].us - (long long)a.records[matched].us;
+    sum += dt;
+    if (llabs(dt) > llabs(worst)) {
+      worst = dt;
+      worstAt = matched;
+    }
+    if (matched > 0) order.push_back(matched);
+  }
+  auto step = [&](size_t x) { return (long long)b.records[x].delta - (long long)a.records[x].delta; };
+  std::sort(order.begin(), order.end(), [&](size_t x, size_t y) { return llabs(step(x)) > llabs(step(y)); });
+
+  printf("===Compare (recorded vs replayed)===\n");
+  printf("[INFO] Records: %zu recorded, %zu replayed, %zu matching\n", a.records.size(), b.records.size(), matched);
+  if (a.lost || b.lost) printf("[WARNING] Lost records: %lu recorded, %lu replayed - expect a divergence there\n", a.lost, b.lost);
+  if (matched > 0) {
+    printf("[INFO] Timing delta (replayed - recorded, since START): mean %+.0f us, worst %+lld us at #%zu %s\n", sum / matched, worst,
+           worstAt, describe(a.records[worstAt]).c_str());
+    printf("[INFO] Final delta: %+lld us over %.3f s\n", (long long)b.records[matched - 1].us - (long long)a.records[matched - 1].us,
+           a.records[matched - 1].us / 1e6);
+    printf("[INFO] Largest step differences (time since the previous record):\n");
+    for (size_t x = 0; x < order.size() && x < 5; x++) {
+      size_t i = order[x];
+      printf("  #%-6zu %-40s recorded %9lu us, replayed %9lu us (%+lld)\n", i, describe(a.records[i]).c_str(), a.records[i].delta,
+             b.records[i].delta, step(i));
+    }
+  }
+  if (matched < a.records.size() || matched < b.records.size()) {
+    printf("[ERROR] Sessions diverge at record #%zu:\n", matched);
+    printf("  recorded: %s\n", matched < a.records.size() ? describe(a.records[matched]).c_str() : "(end)");
+    printf("  replayed: %s\n", matched < b.records.size() ? describe(b.records[matched]).c_str() : "(end)");
+    return 1;
+  }
+  printf("[SUCCESS] The replayed session matches the recorded one record for record.\n");
+  return 0;
+}
+
+int compare_files(const char *recorded, const char *replayed) {
+  Parser a, b;
+  if (!load(recorded, a) || !load(replayed, b)) return 1;
+  return compare(a.sessions[0], b.sessions[0]);
+}
+
+class Port {
+public:
+  ~Port() {
+    if (fd >= 0) close(fd);
+  }
+  bool open_port(const char *path, int baud) {
+    fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0) {
+      perror(path);
+      return false;
+    }
+    termios tio;
+    if (tcgetattr(fd, &tio) == 0) {
+      cfmakeraw(&tio);
+      tio.c_cflag |= CLOCAL | CREAD;
+      speed_t speed = baud == 9600 ? B9600 : baud == 19200 ? B19200 : baud == 38400 ? B38400 : baud == 57600 ? B57600 : B115200;
+      cfsetispeed(&tio, speed);
+      cfsetospeed(&tio, speed);
+      tcsetattr(fd, TCSANOW, &tio);
+      tcflush(fd, TCIOFLUSH);
+    }
+    return true;
+  }
+  bool send(const void *data, size_t len) {
+    const char *p = (const char *)data;
+    while (len > 0) {
+      ssize_t n = write(fd, p, len);
+      if (n < 0) {
+        if (errno != EAGAIN) {
+          perror("write");
+          return false;
+        }
+        pollfd w = {fd, POLLOUT, 0};
+        poll(&w, 1, 100);
+        continue;
+      }
+      p += n;
+      len -= n;
+    }
+    return true;
+  }
+  ssize_t receive(unsigned char *buf, size_t len, int timeoutMs) {
+    pollfd r = {fd, POLLIN, 0};
+    if (poll(&r, 1, timeoutMs) <= 0) return 0;
+    ssize_t n = read(fd, buf, len);
+    return n < 0 ? 0 : n;
+  }
+  void settle() {                 //Opening the port resets most boards: waits for the banner to stop
+    unsigned char buf[256];
+    Clock::time_point until = Clock::now() + std::chrono::seconds(3);
+    while (Clock::now() < until) {
+      if (receive(buf, sizeof(buf), 400) == 0) break;
+    }
+  }
+  int fd = -1;
+};
+
+class Capture {                   //Saves the raw output & parses it as it comes
+public:
+  bool open_file(const char *path) {
+    file = fopen(path, "wb");
+    if (!file) perror(path);
+    return file != nullptr;
+  }
+  ~Capture() {
+    if (file) fclose(file);
+  }
+  void poll_port(Port &port, int timeoutMs, bool echo) {
+    unsigned char buf[512];
+    ssize_t n = port.receive(buf, sizeof(buf), timeoutMs);
+    if (n <= 0) return;
+    fwrite(buf, 1, n, file);
+    parser.feed(buf, n);
+    if (echo && parser.text.size() > echoed) {
+      fwrite(parser.text.data() + echoed, 1, parser.text.size() - echoed, stdout);
+      fflush(stdout);
+      echoed = parser.text.size();
+    }
+  }
+  bool started() {
+    return !parser.sessions.empty();
+  }
+  bool stopped() {
+    return started() && parser.sessions[0].stopped;
+  }
+  Parser parser;
+private:
+  FILE *file = nullptr;
+  size_t echoed = 0;
+};
+
+bool wait_until(Port &port, Capture &capture, bool (Capture::*done)(), double seconds, bool echo) {
+  Clock::time_point until = Clock::now() + std::chrono::milliseconds((long)(seconds * 1000));
+  while (!(capture.*done)()) {
+    if (Clock::now() >= until) return false;
+    capture.poll_port(port, 50, echo);
+  }
+  return true;
+}
+
+int capture(const char *portPath, int baud, const char *out) {
+  Port port;
+  Capture capture;
+  if (!port.open_port(portPath, baud) || !capture.open_file(out)) return 1;
+  port.settle();
+  port.send("T", 1);
+  if (!wait_until(port, capture, &Capture::started, 5, true)) {
+    fprintf(stderr, "[ERROR] The device didn't start a trace, is it built with USE_TRACE?\n");
+    return 1;
+  }
+  fprintf(stderr, "[INFO] Tracing, type the commands (Ctrl-D to stop)...\n");
+  bool input = true;
+  while (input) {
+    pollfd in = {STDIN_FILENO, POLLIN, 0};
+    if (poll(&in, 1, 0) > 0) {
+      char buf[256];
+      ssize_t n = read(STDIN_FILENO, buf, sizeof(buf));
+      if (n <= 0) input = false;
+      else port.send(buf, n);
+    }
+    capture.poll_port(port, 20, true);
+    if (capture.stopped()) break;             //'T' typed
+  }
+  if (!capture.stopped()) port.send("T", 1);
+  if (!wait_until(port, capture, &Capture::stopped, 10, true)) fprintf(stderr, "[WARNING] No STOP record, the trace may be cut\n");
+  fprintf(stderr, "[SUCCESS] Trace saved to %s\n", out);
+  return 0;
+}
+
+int replay(const char *recordedPath, const char *portPath, int baud, const char *out) {
+  Parser recorded;
+  if (!load(recordedPath, recorded)) return 1;
+  const Session &session = recorded.sessions[0];
+  std::vector<std::pair<unsigned long long, unsigned char>> inputs; //Each Byte at the time it arrived
+  std::vector<const Record *> read;
+  size_t noticed = 0;
+  for (const Record &r : session.records) {
+    if (r.type == SERIAL_IN) read.push_back(&r);
+    if (r.type == SERIAL_RX) noticed += r.payload[0];
+  }
+  size_t next = 0;
+  while (next + noticed < read.size()) inputs.push_back({0, read[next++]->payload[0]});  //Already there at the START
+  for (const Record &r : session.records) {
+    for (int x = 0; r.type == SERIAL_RX && x < r.payload[0] && next < read.size(); x++) inputs.push_back({r.us, read[next++]->payload[0]});
+  }
+  for (; next < read.size(); next++) inputs.push_back({read[next]->us, read[next]->payload[0]}); //Their SERIAL_RX were lost
+  std::stable_sort(inputs.begin(), inputs.end(), [](const std::pair<unsigned long long, unsigned char> &x,
+                                                     const std::pair<unsigned long long, unsigned char> &y) { return x.first < y.first; });
+  unsigned long long end = session.records.back().us;
+
+  Port port;
+  Capture capture;
+  if (!port.open_port(portPath, baud) || !capture.open_file(out)) return 1;
+  port.settle();
+  port.send("T", 1);
+  if (!wait_until(port, capture, &Capture::started, 5, false)) {
+    fprintf(stderr, "[ERROR] The device didn't start a trace, is it built with USE_TRACE?\n");
+    return 1;
+  }
+  Clock::time_point zero = Clock::now();      //Our view of the START, off by the (constant) serial latency
+  printf("[INFO] Replaying %zu input Bytes over %.3f s...\n", inputs.size(), end / 1e6);
+  fflush(stdout);
+
+  next = 0;
+  while (next < inputs.size() && !capture.stopped()) {
+    long long due = (long long)inputs[next].first -
+                    std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - zero).count();
+    if (due <= 0) {
+      port.send(&inputs[next].second, 1);
+      next++;
+      continue;
+    }
+    capture.poll_port(port, (int)std::min(due / 1000, 20LL), false);
+  }
+  if (!session.stopped && !capture.stopped()) {  //The recording ended without 'T', stop where it ended
+    while (std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - zero).count() < (long long)end) {
+      capture.poll_port(port, 20, false);
+    }
+    port.send("T", 1);
+  }
+  if (!wait_until(port, capture, &Capture::stopped, end / 1e6 + 10, false)) {
+    fprintf(stderr, "[WARNING] No STOP record in the replay, comparing what arrived\n");
+  }
+  return compare(session, capture.parser.sessions[0]);
+}
+
+void usage() {
+  fprintf(stderr,
+    "Usage: trace_tool capture [-b baud] <port> <trace.bin>\n"
+    "       trace_tool decode [-t] <trace.bin>\n"
+    "       trace_tool replay [-b baud] <trace.bin> <port> <replay.bin>\n"
+    "       trace_tool compare <recorded.bin> <replayed.bin>\n");
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    usage();
+    return 2;
+  }
+  std::string mode = argv[1];
+  int baud = 115200;
+  bool withText = false;
+  optind = 2;
+  int c;
+  while ((c = getopt(argc, argv, "b:t")) != -1) {
+    switch (c) {
+      case 'b': baud = atoi(optarg); break;
+      case 't': withText = true; break;
+      default: usage(); return 2;
+    }
+  }
+  int args = argc - optind;
+  char **arg = argv + optind;
+  if (mode == "capture" && args == 2) return capture(arg[0], baud, arg[1]);
+  if (mode == "decode" && args == 1) return decode(arg[0], withText);
+  if (mode == "replay" && args == 3) return replay(arg[0], arg[1], baud, arg[2]);
+  if (mode == "compare" && args == 2) return compare_files(arg[0], arg[1]);
+  usage();
+  return 2;
+}